@@ -0,0 +1,74 @@
+#ifndef ACTIVITY_H
+#define ACTIVITY_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "platform.h"
+#include "memory.h"
+
+// ======================= Activity Counters and Energy =======================
+// Every microarchitectural event of the pipeline model bumps one counter in
+// a per-PC table: the row of the instruction that caused it (the fetched PC
+// in IF, the decoded instruction in ID, the executing one in EX). Events
+// outside any stage, such as loading a program or presetting registers, go
+// to the ACTIVITY_NO_PC row. Counting is an increment through a row pointer
+// that each stage sets once; energy is only computed when a report is
+// printed, by weighting the counts with an EnergyTable.
+//
+// Counting is off unless a table is installed (setActivityTable), and the
+// row pointer is then NULL, so an event costs a test of a thread-local
+// pointer. Latch toggles are counted with the rest (setLatchToggleCounting),
+// at the cost of a pack and popcount of both latches every cycle. The block
+// engine bypasses the counted accessors, so activity is only complete for
+// runs on the pipeline engine.
+
+typedef enum {
+    ACT_FETCH,          // Instruction-memory read
+    ACT_DECODE,         // Instruction decoded into ID/EX
+    ACT_REG_READ,       // readRegister()
+    ACT_REG_WRITE,      // writeRegister()
+    ACT_ALU_ADD,
+    ACT_ALU_SUB,
+    ACT_ALU_MUL,
+    ACT_ALU_LOGIC,      // ANDI, EOR
+    ACT_ALU_SHIFT,      // SAL, SAR
+    ACT_MEM_READ,       // Data-memory read
+    ACT_MEM_WRITE,      // Data-memory write
+    ACT_LATCH_TOGGLE,   // IF_ID / ID_EX bits that changed at a clock edge
+    ACT_COUNT
+} ActivityEvent;
+
+#define ACTIVITY_NO_PC INSTRUCTION_MEMORY_SIZE
+#define ACTIVITY_ROWS  (INSTRUCTION_MEMORY_SIZE + 1)
+
+typedef uint64_t ActivityCounts[ACTIVITY_ROWS][ACT_COUNT];
+
+// Energy per event in picojoules
+typedef struct {
+    double picojoules[ACT_COUNT];
+} EnergyTable;
+
+// Row of the instruction the current stage works on; NULL when not counting
+extern SIM_THREAD_LOCAL uint64_t* activityRow;
+extern SIM_THREAD_LOCAL uint64_t (*activityTable)[ACT_COUNT];
+
+// Macros rather than inline functions, so an unoptimized build pays only
+// the pointer test while counting is off
+#define COUNT_ACTIVITY(event) do { if (activityRow) activityRow[event]++; } while (0)
+#define COUNT_ACTIVITY_N(event, n) do { if (activityRow) activityRow[event] += (n); } while (0)
+#define SET_ACTIVITY_PC(pc) do { \
+        if (activityTable) { \
+            uint16_t activityPc_ = (pc); \
+            activityRow = activityTable[activityPc_ < INSTRUCTION_MEMORY_SIZE ? activityPc_ : ACTIVITY_NO_PC]; \
+        } \
+    } while (0)
+
+// Function Prototypes
+void setActivityTable(uint64_t (*table)[ACT_COUNT]);
+void initActivity();
+void defaultEnergyTable(EnergyTable* energy);
+int parseEnergyTable(const char* text, EnergyTable* energy);
+void printEnergyReport(const ActivityCounts counts, const uint16_t* program, const EnergyTable* energy,
+                       uint64_t instructions);
+
+#endif // ACTIVITY_H
@@ -0,0 +1,46 @@
+#ifndef ALU_TABLES_H
+#define ALU_TABLES_H
+
+#include <stdint.h>
+#include "registers.h"
+
+// ======================= Table-Driven ALU =======================
+// Precomputed result+flag tables for every 8-bit operand pair, generated
+// ahead of the build by tools/gen_alu_tables.c into src/alu_tables.inc.
+// Each entry packs the result in bits 0-7 and the produced SREG flag bits
+// in bits 8-15. Build with -DUSE_ALU_TABLES (make ALU=tables) to have the
+// execute_* functions use them instead of the branching flag logic.
+
+#define ALU_SHIFT_LIMIT 9   // Shift amounts 0-7, plus one row for every amount >= 8
+
+// SREG bits each operation writes; all other bits are preserved
+#define ALU_FLAGS_ADD   ((1 << CARRY_FLAG) | (1 << OVERFLOW_FLAG) | (1 << NEGATIVE_FLAG) | (1 << SIGN_FLAG) | (1 << ZERO_FLAG))
+#define ALU_FLAGS_SUB   ((1 << OVERFLOW_FLAG) | (1 << NEGATIVE_FLAG) | (1 << SIGN_FLAG) | (1 << ZERO_FLAG))
+#define ALU_FLAGS_NZ    ((1 << NEGATIVE_FLAG) | (1 << ZERO_FLAG))
+
+extern const uint16_t ALU_ADD_TABLE[256 * 256];   // [a][b]
+extern const uint16_t ALU_SUB_TABLE[256 * 256];   // [a][b]
+extern const uint16_t ALU_MUL_TABLE[256 * 256];   // [a][b]
+extern const uint16_t ALU_EOR_TABLE[256 * 256];   // [a][b]
+extern const uint16_t ALU_ANDI_TABLE[256 * 256];  // [imm][a]
+extern const uint16_t ALU_SAL_TABLE[ALU_SHIFT_LIMIT * 256];  // [min(imm, 8)][a]
+extern const uint16_t ALU_SAR_TABLE[ALU_SHIFT_LIMIT * 256];  // [min(imm, 8)][a]
+
+static inline uint16_t aluPairEntry(const uint16_t* table, int8_t a, int8_t b) {
+    return table[((uint8_t)a << 8) | (uint8_t)b];
+}
+
+static inline uint16_t aluShiftEntry(const uint16_t* table, int8_t a, uint8_t amount) {
+    return table[((amount < 8 ? amount : 8) << 8) | (uint8_t)a];
+}
+
+static inline int8_t aluResult(uint16_t entry) {
+    return (int8_t)(entry & 0xFF);
+}
+
+// Merges the entry's flags into a status register value under the op's mask
+static inline uint8_t aluMergeFlags(uint8_t sreg, uint16_t entry, uint8_t mask) {
+    return (uint8_t)((sreg & ~mask) | (entry >> 8));
+}
+
+#endif // ALU_TABLES_H
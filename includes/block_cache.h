@@ -0,0 +1,37 @@
+#ifndef BLOCK_CACHE_H
+#define BLOCK_CACHE_H
+
+#include <stdint.h>
+#include "registers.h"
+#include "memory.h"
+#include "pipeline.h"
+
+// ======================= Basic-Block Translation Cache =======================
+// On first execution of a PC the straight-line run of instructions up to the
+// next BEQZ/BR/HALT is decoded once into an array of specialized handlers
+// with register numbers and immediates baked in. MOVI+ADD and LDR+ADD pairs
+// are fused into single handlers. Blocks are cached by start PC and dropped
+// when a write to instruction memory touches them.
+//
+// runBlocks() executes cached blocks functionally and derives the cycle
+// count from the IF/ID/EX timing (each instruction one cycle, two bubbles
+// per taken branch; one bubble plus the source interlock when branches are
+// resolved in ID), then hands the pipeline back in the exact state the
+// cycle-by-cycle model would have reached.
+
+#define MAX_BLOCK_LENGTH 64     // Longer runs are split into several blocks
+
+// Dynamic counts of one followBlocks() run
+typedef struct {
+    uint64_t instructions;
+    uint64_t takenBranches;
+    uint64_t interlocks;      // ID-stage branch stalls (branch-in-decode mode)
+} BlockRunCounts;
+
+// Function Prototypes
+bool followBlocks(PipelinePosition* position, uint64_t cycleLimit, BlockRunCounts* counts);
+void runBlocks(uint64_t cycleLimit);
+void invalidateBlocks(uint16_t address);
+void flushBlockCache();
+
+#endif // BLOCK_CACHE_H
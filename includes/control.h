@@ -10,6 +10,7 @@
 // Function Prototypes
 void flushPipeline();
 void handleBranchFlush(uint16_t targetPC);
+void redirectFetch(uint16_t targetPC);
 void stallPipeline();
 
 #endif // CONTROL_H
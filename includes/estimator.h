@@ -0,0 +1,35 @@
+#ifndef ESTIMATOR_H
+#define ESTIMATOR_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// ======================= Analytic Cycle Estimator =======================
+// Computes the cycle count of a run without clocking IF_ID/ID_EX. The
+// program runs on the translated-block functional path, which yields the
+// dynamic instruction stream's counts. The IF/ID/EX timing is then applied in
+// closed form:
+//   fill    2 cycles before the first instruction reaches EX
+//   flush   2 bubbles per taken branch (1 when branches resolve in ID, plus
+//           one interlock cycle per branch reading the register written
+//           just before it)
+//   drain   none after the last instruction, and one cycle less when that
+//           instruction is a taken branch: its target HALT is fetched in the
+//           cycle it redirects to
+//   N = 0   1 cycle (HALT is the first fetch)
+// Multi-cycle unit latencies are not modelled; the estimate is refused when
+// any are set.
+
+typedef struct {
+    bool halted;              // false if the cycle budget ran out first
+    uint64_t cycles;          // Total when halted, cycles consumed otherwise
+    uint64_t instructions;
+    uint64_t takenBranches;
+    uint64_t interlocks;
+    bool lastTaken;           // Final instruction was a taken branch
+} CycleEstimate;
+
+// Function Prototypes
+bool estimateCycles(uint64_t cycleLimit, CycleEstimate* estimate);
+
+#endif // ESTIMATOR_H
@@ -15,7 +15,7 @@ void execute_BR(uint8_t r1, uint8_t r2);
 
 // I-Format Instructions (with signed immediates)
 void execute_MOVI(uint8_t r1, int8_t immediate);
-void execute_BEQZ(uint8_t r1, int8_t immediate);
+void execute_BEQZ(uint8_t r1, int8_t immediate, uint16_t nextPC);
 void execute_ANDI(uint8_t r1, int8_t immediate);
 void execute_SAL(uint8_t r1, uint8_t immediate);
 void execute_SAR(uint8_t r1, uint8_t immediate);
@@ -0,0 +1,79 @@
+#ifndef ISA_H
+#define ISA_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// ======================= Instruction Set Definition =======================
+// The one description of the ISA. Every instruction word is
+//   [15:12] opcode | [11:6] R1 | [5:0] operand
+// and the operand's kind fixes how it is assembled, decoded and passed to
+// the execute handler:
+//   REGISTER   second register R0-R63 (R-format)
+//   IMMEDIATE  signed value -32..31, sign-extended in ID
+//   OFFSET     signed PC-relative branch offset -32..31; the handler also
+//              gets the address of the next instruction
+//   SHIFT      shift amount 0..7 (a raw word's 6-bit field is sign-extended
+//              like IMMEDIATE)
+//   ADDRESS    data memory address 0..63, zero-extended
+// The assembler table, the decode table and the dispatch tables of every
+// engine are expanded from ISA_INSTRUCTIONS, and the ID interlock, the
+// scoreboard and the scheduler read the dataflow flags. A new instruction is
+// one line here plus a handler per engine, each found by name so a missing
+// one fails to compile: execute_<NAME> in instruction_set.c, op<NAME> in
+// block_cache.c and emit<NAME> in tools/aot.c. A new kind of branch also
+// needs its block exit and its control flow in aot.
+// Opcodes not listed are reserved: they decode like IMMEDIATE and execute as
+// a one-cycle no-op.
+//
+// Columns: mnemonic, opcode, operand kind, dataflow flags, functional unit.
+
+#define ISA_INSTRUCTIONS(X) \
+    X(ADD,  0,  REGISTER,  ISA_READS_R1 | ISA_READS_R2 | ISA_WRITES_R1 | ISA_WRITES_SREG, ALU)    \
+    X(SUB,  1,  REGISTER,  ISA_READS_R1 | ISA_READS_R2 | ISA_WRITES_R1 | ISA_WRITES_SREG, ALU)    \
+    X(MUL,  2,  REGISTER,  ISA_READS_R1 | ISA_READS_R2 | ISA_WRITES_R1 | ISA_WRITES_SREG, MUL)    \
+    X(MOVI, 3,  IMMEDIATE, ISA_WRITES_R1,                                                 ALU)    \
+    X(BEQZ, 4,  OFFSET,    ISA_READS_R1 | ISA_BRANCH,                                     BRANCH) \
+    X(ANDI, 5,  IMMEDIATE, ISA_READS_R1 | ISA_WRITES_R1 | ISA_WRITES_SREG,                ALU)    \
+    X(EOR,  6,  REGISTER,  ISA_READS_R1 | ISA_READS_R2 | ISA_WRITES_R1 | ISA_WRITES_SREG, ALU)    \
+    X(BR,   7,  REGISTER,  ISA_READS_R1 | ISA_READS_R2 | ISA_BRANCH,                      BRANCH) \
+    X(SAL,  8,  SHIFT,     ISA_READS_R1 | ISA_WRITES_R1 | ISA_WRITES_SREG,                ALU)    \
+    X(SAR,  9,  SHIFT,     ISA_READS_R1 | ISA_WRITES_R1 | ISA_WRITES_SREG,                ALU)    \
+    X(LDR,  10, ADDRESS,   ISA_WRITES_R1 | ISA_LOADS,                                     MEM)    \
+    X(STR,  11, ADDRESS,   ISA_READS_R1 | ISA_STORES,                                     MEM)
+
+#define OPCODE_COUNT 16
+
+typedef enum {
+    OPERAND_IMMEDIATE,
+    OPERAND_OFFSET,
+    OPERAND_SHIFT,
+    OPERAND_ADDRESS,
+    OPERAND_REGISTER
+} OperandKind;
+
+// Dataflow flags
+#define ISA_READS_R1    0x01
+#define ISA_READS_R2    0x02    // Operand field names a source register
+#define ISA_WRITES_R1   0x04
+#define ISA_WRITES_SREG 0x08
+#define ISA_LOADS       0x10    // Reads data memory at the operand address
+#define ISA_STORES      0x20    // Writes R1 to data memory at the operand address
+#define ISA_BRANCH      0x40    // May redirect fetch
+
+#define ISA_OPCODE_ENUM(name, opcode, operand, flags, unit) OP_##name = opcode,
+typedef enum { ISA_INSTRUCTIONS(ISA_OPCODE_ENUM) } Opcode;
+
+typedef struct {
+    const char* name;       // Assembler mnemonic, NULL for a reserved opcode
+    OperandKind operand;
+    uint8_t flags;
+} InstructionInfo;
+
+// Indexed by opcode
+extern const InstructionInfo ISA_TABLE[OPCODE_COUNT];
+
+// Function Prototypes
+int findOpcode(const char* name);
+
+#endif // ISA_H
@@ -0,0 +1,58 @@
+#ifndef MULTICORE_H
+#define MULTICORE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "registers.h"
+#include "memory.h"
+#include "simulator.h"
+
+// ======================= Multi-Core Guest Simulation =======================
+// Runs N copies of the IF/ID/EX pipeline, each with its own registers and PC,
+// over one shared data memory. Every guest core runs on its own host thread.
+//
+// Cores advance in lock-step quanta of `quantum` cycles. Memory ordering:
+//  - an LDR sees shared memory as it was at the start of the current quantum,
+//    plus the core's own earlier STRs in that quantum;
+//  - STRs become visible to the other cores at the next quantum boundary,
+//    committed in core order (core 0 first, so the highest-numbered core
+//    wins when several cores store to the same address in one quantum).
+// Results therefore depend only on the program, N and the quantum, never on
+// host thread scheduling.
+
+#define MAX_CORES 64
+#define DEFAULT_QUANTUM 100
+
+typedef struct {
+    int cores;                 // Number of guest cores (1 - MAX_CORES)
+    uint32_t quantum;          // Cycles per synchronization quantum
+    uint64_t maxCycles;        // Per-core cycle budget, 0 for unlimited
+    int coreIdRegister;        // Register preloaded with the core number, -1 for none
+    SimEngine engine;          // Execution engine of every core
+    SimBranchStage branchStage; // Branch resolution stage of every core
+    uint8_t latencies[OPCODE_COUNT]; // EX cycles per opcode, 0 for the default of 1
+} MultiCoreConfig;
+
+typedef struct {
+    int8_t registers[REGISTER_COUNT];
+    uint8_t sreg;
+    uint16_t pc;
+    uint64_t cycles;
+    uint64_t instructions;
+    bool halted;
+    double busySeconds;        // Host time spent simulating this core
+} CoreResult;
+
+typedef struct {
+    CoreResult cores[MAX_CORES];
+    int8_t dataMemory[DATA_MEMORY_SIZE];   // Final shared data memory
+    uint64_t quanta;
+    double wallSeconds;
+} MultiCoreResult;
+
+// Function Prototypes
+int runMultiCore(const uint16_t image[INSTRUCTION_MEMORY_SIZE], const MultiCoreConfig* config,
+                 MultiCoreResult* result);
+void printMultiCoreReport(const MultiCoreConfig* config, const MultiCoreResult* result);
+
+#endif // MULTICORE_H
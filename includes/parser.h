@@ -2,6 +2,7 @@
 #define PARSER_H
 
 #include <stdint.h>
+#include <stddef.h>
 #include "memory.h"
 
 /**
@@ -11,6 +12,14 @@
  */
 int parseInstructionFile(const char* filename);
 
+/**
+ * Parses program source held in memory and stores it in instruction memory.
+ * @param source: Program text, one instruction per line (need not be NUL-terminated)
+ * @param length: Number of bytes in source
+ * @return: Number of instructions successfully parsed and stored
+ */
+int parseInstructionBuffer(const char* source, size_t length);
+
 /**
  * Prints the binary representation of an instruction
  * @param instruction: 16-bit instruction to print
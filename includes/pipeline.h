@@ -7,6 +7,7 @@
 #include "memory.h"
 #include "instruction_set.h"
 #include "control.h"
+#include "scoreboard.h"
 
 // ======================= Pipeline Register Structures =======================
 
@@ -24,20 +25,60 @@ typedef struct {
     uint8_t r2;            // Register 2 or Immediate (6 bits)
     bool isImmediate;      // Whether this is I-Format or R-Format
     uint16_t nextPC;       // Next program counter value
+    bool resolved;         // Branch already resolved in ID (branch-in-decode mode)
+    bool taken;            // Outcome of a resolved branch
+    uint16_t target;       // Target of a resolved taken branch
     bool valid;            // If this stage holds valid data
 } ID_EX_Reg;
 
+#define NO_REGISTER 0xFF   // No destination register
+
 // ======================= Pipeline Register Declarations =======================
-extern IF_ID_Reg IF_ID;
-extern ID_EX_Reg ID_EX;
-extern bool isStalled;
+extern SIM_THREAD_LOCAL IF_ID_Reg IF_ID;
+extern SIM_THREAD_LOCAL ID_EX_Reg ID_EX;
+extern SIM_THREAD_LOCAL bool isStalled;
+
+// Everything needed to suspend and later resume a pipeline
+typedef struct {
+    IF_ID_Reg ifId;
+    ID_EX_Reg idEx;
+    uint64_t cycle;
+    uint64_t instructionCount;
+    bool halted;
+    bool stalled;
+    Scoreboard scoreboard;
+} PipelineSnapshot;
+
+// Where a functional engine can pick up (and hand back) a running pipeline:
+// the next instruction to execute and the cycle in which it would reach EX.
+// `streaming` is false right after a taken branch or reset, when the
+// pipeline is empty and must refill before that instruction executes.
+// `lastWrite` is the register written by the instruction executed just
+// before, which a branch resolved in ID has to wait for.
+typedef struct {
+    uint16_t pc;
+    uint64_t nextExecute;
+    bool streaming;
+    uint8_t lastWrite;
+} PipelinePosition;
 
 // ======================= Pipeline Function Prototypes =======================
 void initPipeline();
 void fetchStage();
 void decodeStage();
+void decodeFields(uint16_t instr, ID_EX_Reg* latch);
 void executeStage();
 bool pipelineCycle();
 void printPipelineState();
+bool isPipelineDrained();
+void setBranchInDecode(bool enabled);
+void setLatchToggleCounting(bool enabled);
+bool isBranchInDecode();
+uint64_t getCycleCount();
+uint64_t getInstructionCount();
+void savePipeline(PipelineSnapshot* snapshot);
+void restorePipeline(const PipelineSnapshot* snapshot);
+bool savePipelinePosition(PipelinePosition* position);
+void restorePipelinePosition(const PipelinePosition* position, uint64_t executed);
 
 #endif // PIPELINE_H
\ No newline at end of file
@@ -0,0 +1,66 @@
+#ifndef PIPELINE5_H
+#define PIPELINE5_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "pipeline.h"
+
+// ======================= Five-Stage Pipeline Model =======================
+// Classic IF/ID/EX/MEM/WB timing over the same architectural state as the
+// three-stage model. ALU results are forwarded from the EX/MEM and MEM/WB
+// latches into EX, so they are visible to the next instruction without a
+// stall; the model applies them to the register file at the end of EX, which
+// is what full forwarding makes architecturally visible. LDR and STR access
+// data memory in MEM, so an instruction that reads a loaded register right
+// after the load waits one cycle (load-use stall). STR needs its data only in
+// MEM and is forwarded without a stall. Instructions retire in WB.
+//
+// Branches resolve in EX (two flushed slots per taken branch) or, with
+// setBranchInDecode(), in ID (one flushed slot). A branch in ID waits one
+// cycle for an ALU result from the instruction right before it and two for a
+// load. Multi-cycle unit latencies and the block engine apply to the
+// three-stage model only.
+
+// EX/MEM and MEM/WB latches: the instruction moving down the pipeline
+typedef struct {
+    uint8_t opcode;
+    uint8_t r1;
+    uint8_t r2;            // Source register, data address or immediate
+    uint16_t nextPC;
+    bool taken;            // Branch outcome, for the retirement record
+    bool valid;
+} EX_MEM_Reg;
+
+typedef EX_MEM_Reg MEM_WB_Reg;
+
+typedef struct {
+    uint64_t loadUseStalls;     // Cycles an instruction waited in ID for a load
+    uint64_t branchStalls;      // Cycles a branch resolved in ID waited for its sources
+    uint64_t takenBranches;     // Flushes
+    uint64_t forwardsExMem;     // EX operands taken from the instruction one ahead
+    uint64_t forwardsMemWb;     // EX operands taken from the instruction two ahead
+} Pipeline5Stats;
+
+typedef struct {
+    IF_ID_Reg ifId;
+    ID_EX_Reg idEx;
+    EX_MEM_Reg exMem;
+    MEM_WB_Reg memWb;
+    uint64_t cycle;
+    uint64_t instructionCount;
+    bool halted;
+    Pipeline5Stats stats;
+} Pipeline5Snapshot;
+
+// Function Prototypes
+void initPipeline5();
+bool pipeline5Cycle();
+bool isPipeline5Drained();
+uint64_t getPipeline5Cycles();
+uint64_t getPipeline5Instructions();
+const Pipeline5Stats* getPipeline5Stats();
+bool peekPipeline5Execute(uint16_t* pc);
+void savePipeline5(Pipeline5Snapshot* snapshot);
+void restorePipeline5(const Pipeline5Snapshot* snapshot);
+
+#endif // PIPELINE5_H
@@ -0,0 +1,21 @@
+#ifndef PLATFORM_H
+#define PLATFORM_H
+
+// Storage class for the machine state globals. Every host thread gets its own
+// registers, memories and pipeline, so independent simulations can run on
+// separate threads at the same time.
+#if defined(_MSC_VER)
+#define SIM_THREAD_LOCAL __declspec(thread)
+#else
+#define SIM_THREAD_LOCAL _Thread_local
+#endif
+
+// Number of set bits in a 64-bit word
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define SIM_POPCOUNT64(x) ((uint64_t)__popcnt64(x))
+#else
+#define SIM_POPCOUNT64(x) ((uint64_t)__builtin_popcountll(x))
+#endif
+
+#endif // PLATFORM_H
@@ -0,0 +1,46 @@
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#include <stdint.h>
+
+// ======================= Host Self-Profiling =======================
+// Build with -DSIM_PROFILE (make PROFILE=1) to time the simulator's own
+// phases: every pipeline stage and whole cycle, program loading, block-engine
+// runs and the state dumps. Samples go into per-thread log-linear histograms
+// (a few ns of overhead each), which are merged into a process-wide table
+// when the thread's Simulator is destroyed or it calls PROFILE_FLUSH(). The
+// merged table is printed once at exit with count, mean, p50, p99 and max in
+// ns. Without SIM_PROFILE the PROFILE_* macros compile to nothing.
+
+typedef enum {
+    PROFILE_CYCLE,         // One whole pipelineCycle()
+    PROFILE_EXECUTE,       // executeStage()
+    PROFILE_DECODE,        // decodeStage()
+    PROFILE_FETCH,         // fetchStage()
+    PROFILE_PRINT_STATE,   // printPipelineState() (verbose runs only)
+    PROFILE_BLOCKS,        // One runBlocks() call
+    PROFILE_LOAD,          // Program assembly into instruction memory
+    PROFILE_DUMP,          // Register and memory dumps
+    PROFILE_PHASE_COUNT
+} ProfilePhase;
+
+#ifdef SIM_PROFILE
+
+uint64_t profileNow();
+void profileRecord(ProfilePhase phase, uint64_t start);
+void profileFlushThread();
+void printProfileReport();
+
+#define PROFILE_BEGIN(name) uint64_t profileStart_##name = profileNow()
+#define PROFILE_END(name, phase) profileRecord(phase, profileStart_##name)
+#define PROFILE_FLUSH() profileFlushThread()
+
+#else
+
+#define PROFILE_BEGIN(name) do { } while (0)
+#define PROFILE_END(name, phase) do { } while (0)
+#define PROFILE_FLUSH() do { } while (0)
+
+#endif // SIM_PROFILE
+
+#endif // PROFILE_H
@@ -2,6 +2,7 @@
 #define REGISTERS_H
 
 #include <stdint.h>   // For uint8_t and uint16_t types
+#include "platform.h"
 
 // Register Sizes
 #define REGISTER_COUNT 64
@@ -14,9 +15,9 @@
 #define ZERO_FLAG      0  // Zero Flag
 
 // Register Declarations
-extern int8_t registers[REGISTER_COUNT];  // 64 General Purpose Registers (signed)
-extern uint8_t SREG;                       // Status Register (8 bits)
-extern uint16_t PC;                        // Program Counter (16 bits)
+extern SIM_THREAD_LOCAL int8_t registers[REGISTER_COUNT];  // 64 General Purpose Registers (signed)
+extern SIM_THREAD_LOCAL uint8_t SREG;                    // Status Register (8 bits)
+extern SIM_THREAD_LOCAL uint16_t PC;                     // Program Counter (16 bits)
 
 // Function Prototypes
 void initRegisters();
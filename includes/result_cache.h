@@ -0,0 +1,63 @@
+#ifndef RESULT_CACHE_H
+#define RESULT_CACHE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "registers.h"
+#include "memory.h"
+
+// ======================= On-Disk Result Store =======================
+// Memoizes whole runs. A RunKey hashes everything a run's outcome depends
+// on: the instruction memory image, the non-zero initial registers, SREG,
+// PC and data memory, and the configuration that affects results or timing
+// (pipeline depth, branch stage, unit latencies, cycle budget). The store is a
+// directory of one file per key holding the final state and counters.
+//
+// Several processes (and threads) may share a directory. Entries are
+// written to a temporary file and renamed into place, so a reader sees a
+// complete entry or none. Bookkeeping and eviction run under an exclusive
+// flock() on the directory's lock file. When the store grows past its size
+// limit, the least recently used entries are removed until it is back
+// under 90% of the limit. A hit refreshes the entry's modification time.
+//
+// A cached run replays no callbacks or trace output. Callers that need
+// per-event streams, or stop at breakpoints, must not use the store.
+
+#define RESULT_CACHE_COUNTERS 8
+
+typedef struct {
+    uint64_t hash;         // File name
+    uint64_t check;        // Independent hash stored in the entry and compared on lookup
+} RunKey;
+
+typedef struct {
+    uint8_t reason;        // SimStopReason of the run
+    uint8_t sreg;
+    uint16_t pc;
+    uint64_t cycles;
+    uint64_t instructions;
+    uint64_t counters[RESULT_CACHE_COUNTERS];    // Caller-defined (e.g. branches taken)
+    int8_t registers[REGISTER_COUNT];
+    int8_t dataMemory[DATA_MEMORY_SIZE];
+} CachedResult;
+
+typedef struct ResultCache ResultCache;
+
+// Incremental hashing of key material
+typedef struct {
+    uint64_t hash;
+    uint64_t check;
+} RunKeyBuilder;
+
+// Function Prototypes
+void beginRunKey(RunKeyBuilder* builder);
+void addToRunKey(RunKeyBuilder* builder, const void* data, size_t length);
+void finishRunKey(const RunKeyBuilder* builder, RunKey* key);
+
+ResultCache* openResultCache(const char* directory, uint64_t maxBytes);
+void closeResultCache(ResultCache* cache);
+bool lookupResult(ResultCache* cache, const RunKey* key, CachedResult* result);
+int storeResult(ResultCache* cache, const RunKey* key, const CachedResult* result);
+
+#endif // RESULT_CACHE_H
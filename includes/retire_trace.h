@@ -0,0 +1,35 @@
+#ifndef RETIRE_TRACE_H
+#define RETIRE_TRACE_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include "trace.h"
+
+// ======================= Retirement Trace Files =======================
+// A recorded run: a fixed header followed by one packed RetireRecord per
+// executed instruction, in program order. Written once by
+// `processor --record-trace`, replayed by tools/trace_replay.c.
+
+#define RETIRE_TRACE_MAGIC   0x544D4953u   // "SIMT"
+#define RETIRE_TRACE_VERSION 1
+
+typedef struct {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t recordSize;       // sizeof(RetireRecord)
+    uint64_t recordCount;
+    uint64_t recordedCycles;   // Cycles the pipeline model took for this run
+} RetireTraceHeader;
+
+typedef struct {
+    FILE* file;
+    RetireTraceHeader header;
+} RetireTraceWriter;
+
+// Function Prototypes
+void describeRetirement(RetireRecord* record, uint16_t pc, uint8_t opcode, uint8_t r1, uint8_t r2, bool taken);
+int openRetireTrace(RetireTraceWriter* writer, const char* path);
+void recordRetirement(void* user, const RetireRecord* record);
+int closeRetireTrace(RetireTraceWriter* writer, uint64_t cycles);
+
+#endif // RETIRE_TRACE_H
@@ -0,0 +1,46 @@
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "memory.h"
+
+// ======================= Instruction Scheduling =======================
+// Optional pass over an assembled program: every basic block gets a
+// dependency DAG (registers, SREG, data memory) and is list-scheduled so
+// that consumers sit further from their producers under an interlocked
+// latency model. Block boundaries, branch positions and branch offsets stay
+// where they are, SREG writers and memory accesses keep their relative
+// order, and a block is only rewritten if the model predicts fewer stalls.
+// BR targets must be provable from MOVIs in the branch's own block;
+// otherwise the whole program is left untouched.
+//
+// The IF/ID/EX pipeline has no data interlocks, so its own cycle count does
+// not change; the savings apply to timing models that stall on RAW hazards
+// (trace_replay with load/mul latencies, branches resolved in ID).
+
+// Result latencies assumed by the pass (cycles from issue to use)
+typedef struct {
+    uint8_t aluLatency;       // ADD/SUB/EOR/ANDI/SAL/SAR/MOVI
+    uint8_t mulLatency;       // MUL
+    uint8_t loadLatency;      // LDR
+    uint8_t branchEarly;      // Extra cycles a branch needs its sources early
+} ScheduleModel;
+
+#define DEFAULT_SCHEDULE_MODEL {1, 2, 2, 1}
+
+typedef struct {
+    bool applied;             // False if the program could not be analyzed
+    char reason[64];          // Why not, when applied is false
+    int blocks;               // Basic blocks analyzed
+    int rescheduled;          // Blocks rewritten
+    int moved;                // Instructions whose address changed
+    uint64_t stallsBefore;    // Predicted stalls, one pass through every block
+    uint64_t stallsAfter;
+} ScheduleReport;
+
+// Function Prototypes
+int parseScheduleModel(const char* text, ScheduleModel* model);
+void scheduleProgram(const ScheduleModel* model, ScheduleReport* report);
+
+#endif // SCHEDULER_H
@@ -0,0 +1,69 @@
+#ifndef SCOREBOARD_H
+#define SCOREBOARD_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "registers.h"
+#include "isa.h"
+
+// ======================= Multi-Cycle Units and Scoreboard =======================
+// Every opcode has an EX latency (default 1) and runs on one functional
+// unit. A unit is busy for the whole latency of the instruction it holds.
+// The instruction waiting in ID/EX issues when its source registers are
+// ready (RAW), no earlier instruction still has a write pending to its
+// destination (WAW) and its unit is free (structural). Until then it stays
+// in ID, and fetch and decode stall behind it. Instructions on other units
+// keep issuing while a long one is in flight. Operands are read at issue and
+// issue is in order, so there are no WAR hazards. No instruction reads SREG,
+// so flag updates never stall; they are applied in program order.
+//
+// Results are computed functionally at issue; the scoreboard only decides
+// when dependents may issue. With every latency at 1 nothing ever stalls and
+// timing is exactly the single-cycle IF/ID/EX model.
+
+typedef enum {
+    UNIT_ALU,       // ADD SUB MOVI ANDI EOR SAL SAR (and unknown opcodes)
+    UNIT_MUL,       // MUL
+    UNIT_MEM,       // LDR STR
+    UNIT_BRANCH,    // BEQZ BR (always single-cycle)
+    UNIT_COUNT
+} FunctionalUnit;
+
+typedef enum {
+    HAZARD_NONE,
+    HAZARD_RAW,
+    HAZARD_WAW,
+    HAZARD_STRUCTURAL
+} IssueHazard;
+
+typedef struct {
+    uint64_t issued[UNIT_COUNT];        // Instructions issued to each unit
+    uint64_t busyCycles[UNIT_COUNT];    // Cycles each unit was occupied
+    uint64_t rawStalls;                 // Cycles ID waited for a source register
+    uint64_t wawStalls;                 // Cycles ID waited for a pending write to its destination
+    uint64_t structuralStalls;          // Cycles ID waited for a busy unit
+} ScoreboardStats;
+
+typedef struct {
+    uint64_t ready[REGISTER_COUNT];     // First cycle a consumer may issue
+    uint64_t busyUntil[UNIT_COUNT];     // Last cycle each unit is occupied
+    uint64_t lastBusy;                  // Last cycle any unit is occupied
+    ScoreboardStats stats;
+} Scoreboard;
+
+extern SIM_THREAD_LOCAL Scoreboard scoreboard;
+
+// Function Prototypes
+void initScoreboard();
+void setOpcodeLatencies(const uint8_t latencies[OPCODE_COUNT]);
+bool hasMultiCycleOps();
+int parseLatencies(const char* text, uint8_t latencies[OPCODE_COUNT]);
+FunctionalUnit unitOf(uint8_t opcode);
+IssueHazard checkIssue(uint8_t opcode, uint8_t r1, uint8_t r2, uint64_t cycle);
+void recordIssue(uint8_t opcode, uint8_t r1, uint64_t cycle);
+void recordStall(IssueHazard hazard);
+bool isRegisterPending(uint8_t reg, uint64_t cycle);
+bool areUnitsIdle(uint64_t cycle);
+void printScoreboardReport(const ScoreboardStats* stats, uint64_t cycles);
+
+#endif // SCOREBOARD_H
@@ -0,0 +1,78 @@
+#ifndef SIM_PROTOCOL_H
+#define SIM_PROTOCOL_H
+
+#include <stdint.h>
+#include "registers.h"
+#include "memory.h"
+
+// ======================= Simulation Server Wire Protocol =======================
+// Binary frames exchanged over a local Unix domain socket, in host byte order.
+//
+// Client -> server: SimJobHeader followed by payloadLength bytes of program
+//   (assembly source text, or assembled 16-bit instruction words).
+// Server -> client: SimJobResult followed by the optional sections selected
+//   in outputs, in this order: registers (REGISTER_COUNT bytes), data memory
+//   (DATA_MEMORY_SIZE bytes).
+//
+// Results come back tagged with the job id, in completion order. Each
+// connection has its own writer on the server, so a client that stops
+// reading stalls only its own connection. The server takes a connection's
+// next job only while its unsent results stay within a window of
+// SIM_PROTOCOL_MAX_OUTSTANDING jobs and SIM_PROTOCOL_MAX_OUTSTANDING_BYTES
+// (SIM_RESULT_BYTES per job, a lone job always fits); past that it stops
+// reading. A client that writes beyond the window without reading results
+// blocks in its own write, so it should keep at most a window in flight.
+
+#define SIM_PROTOCOL_JOB_MAGIC    0x514D4953u   // "SIMQ"
+#define SIM_PROTOCOL_RESULT_MAGIC 0x524D4953u   // "SIMR"
+#define SIM_PROTOCOL_MAX_PAYLOAD  (64 * 1024)
+#define SIM_PROTOCOL_MAX_OUTSTANDING       256            // Jobs per connection
+#define SIM_PROTOCOL_MAX_OUTSTANDING_BYTES (256 * 1024)   // Result bytes per connection
+#define SIM_DEFAULT_SOCKET_PATH   "/tmp/sim_server.sock"
+
+// Payload kinds
+#define SIM_PAYLOAD_SOURCE 0   // Assembly text, as accepted by parseInstructionBuffer
+#define SIM_PAYLOAD_IMAGE  1   // Assembled 16-bit instruction words
+
+// Optional result sections
+#define SIM_OUTPUT_REGISTERS   0x01
+#define SIM_OUTPUT_DATA_MEMORY 0x02
+
+// Job status
+#define SIM_JOB_HALTED      0   // Program ran to HALT
+#define SIM_JOB_CYCLE_LIMIT 1   // Stopped at the cycle limit
+#define SIM_JOB_BAD_REQUEST 2   // Unknown payload kind or oversized payload
+
+typedef struct {
+    uint32_t magic;          // SIM_PROTOCOL_JOB_MAGIC
+    uint32_t jobId;          // Echoed back in the result
+    uint8_t payloadType;     // SIM_PAYLOAD_*
+    uint8_t outputs;         // SIM_OUTPUT_* bits
+    uint16_t reserved;
+    uint32_t cycleLimit;     // 0 = server default
+    uint32_t payloadLength;  // Bytes of program that follow
+} SimJobHeader;
+
+typedef struct {
+    uint32_t magic;          // SIM_PROTOCOL_RESULT_MAGIC
+    uint32_t jobId;
+    uint8_t status;          // SIM_JOB_*
+    uint8_t outputs;         // SIM_OUTPUT_* sections that follow
+    uint8_t sreg;
+    uint8_t reserved;
+    uint16_t pc;
+    uint16_t instructionsLoaded;
+    uint64_t cycles;
+    uint64_t instructions;   // Instructions that reached EX
+    uint32_t branchesTaken;
+    uint32_t memoryWrites;   // Data memory writes
+    uint32_t payloadLength;  // Bytes of optional sections that follow
+    uint32_t reserved2;
+} SimJobResult;
+
+// Bytes of the result frame of a job requesting outputs
+#define SIM_RESULT_BYTES(outputs) ((uint32_t)sizeof(SimJobResult) + \
+    (((outputs) & SIM_OUTPUT_REGISTERS) ? REGISTER_COUNT : 0) + \
+    (((outputs) & SIM_OUTPUT_DATA_MEMORY) ? DATA_MEMORY_SIZE : 0))
+
+#endif // SIM_PROTOCOL_H
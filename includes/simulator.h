@@ -0,0 +1,112 @@
+#ifndef SIMULATOR_H
+#define SIMULATOR_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "trace.h"
+#include "registers.h"
+#include "memory.h"
+#include "scheduler.h"
+#include "scoreboard.h"
+#include "estimator.h"
+#include "activity.h"
+#include "pipeline5.h"
+#include "result_cache.h"
+#include "stream_io.h"
+
+// ======================= Embeddable Simulator API =======================
+// Each Simulator owns a complete machine. Nothing is printed unless
+// simSetVerbose() is enabled; events are reported through SimCallbacks.
+// The core keeps the active machine in per-thread module globals, so
+// instances are swapped in on demand: switching between instances costs one
+// state copy, repeated calls on the same instance cost nothing. An instance
+// belongs to the thread that uses it; different threads may run different
+// instances concurrently.
+
+typedef struct Simulator Simulator;
+
+// Why simRun() returned
+typedef enum {
+    SIM_HALTED,        // HALT fetched and the pipeline drained
+    SIM_BREAKPOINT,    // An instruction at a breakpoint is about to execute
+    SIM_CYCLE_LIMIT    // maxCycles elapsed first
+} SimStopReason;
+
+// How simRun() advances the machine
+typedef enum {
+    SIM_ENGINE_PIPELINE,   // Cycle-by-cycle IF/ID/EX model (default)
+    SIM_ENGINE_BLOCKS      // Cached translated basic blocks, same results and counts
+} SimEngine;
+
+// Pipeline stage that resolves BEQZ/BR
+typedef enum {
+    SIM_BRANCH_IN_EX,      // Two bubbles per taken branch (default)
+    SIM_BRANCH_IN_ID       // One bubble; stalls a cycle on a source written just before
+} SimBranchStage;
+
+// Pipeline model clocked by the pipeline engine
+typedef enum {
+    SIM_PIPELINE_3_STAGE,  // IF/ID/EX, write-back folded into EX (default)
+    SIM_PIPELINE_5_STAGE   // IF/ID/EX/MEM/WB with forwarding (see pipeline5.h)
+} SimPipelineDepth;
+
+// Lifecycle
+Simulator* simCreate(const SimCallbacks* callbacks);
+void simDestroy(Simulator* sim);
+void simReset(Simulator* sim);
+void simSetVerbose(Simulator* sim, bool verbose);
+void simSetEngine(Simulator* sim, SimEngine engine);
+void simSetBranchStage(Simulator* sim, SimBranchStage stage);
+void simSetPipelineDepth(Simulator* sim, SimPipelineDepth depth);
+void simSetLatency(Simulator* sim, uint8_t opcode, uint8_t cycles);
+void simSetActivityCounting(Simulator* sim, bool enabled);
+
+// Program loading (each load resets the machine first)
+int simLoadFile(Simulator* sim, const char* filename);
+int simLoadSource(Simulator* sim, const char* source, size_t length);
+int simLoadImage(Simulator* sim, const uint16_t* words, size_t count);
+
+// Optional pass over the loaded program (see scheduler.h)
+void simSchedule(Simulator* sim, const ScheduleModel* model, ScheduleReport* report);
+
+// Initial state
+void simWriteRegister(Simulator* sim, uint8_t regNum, int8_t value);
+size_t simWriteDataMemory(Simulator* sim, uint16_t address, const int8_t* data, size_t length);
+int simLoadDataFile(Simulator* sim, const char* filename, uint16_t address);
+
+// Streaming I/O ports at the top of the LDR/STR address range (see stream_io.h)
+void simAttachStreams(Simulator* sim, StreamDevice* device);
+
+// Execution
+uint64_t simStep(Simulator* sim, uint64_t cycles);
+SimStopReason simRun(Simulator* sim, uint64_t maxCycles);
+void simSetBreakpoint(Simulator* sim, uint16_t address, bool enabled);
+void simClearBreakpoints(Simulator* sim);
+
+// Cycle count without clocking the pipeline (see estimator.h); the machine is left as it was
+bool simEstimateCycles(Simulator* sim, uint64_t maxCycles, CycleEstimate* estimate);
+
+// Run memoization (see result_cache.h): key the run from the loaded state,
+// then either apply a stored result or run and capture one
+bool simRunKey(Simulator* sim, uint64_t maxCycles, RunKey* key);
+void simCaptureResult(Simulator* sim, SimStopReason reason, CachedResult* result);
+void simApplyResult(Simulator* sim, const CachedResult* result);
+
+// State readout into caller-provided buffers
+void simReadRegisters(Simulator* sim, int8_t out[REGISTER_COUNT]);
+uint8_t simReadSREG(Simulator* sim);
+uint16_t simReadPC(Simulator* sim);
+size_t simReadDataMemory(Simulator* sim, uint16_t address, int8_t* out, size_t length);
+size_t simReadInstructionMemory(Simulator* sim, uint16_t address, uint16_t* out, size_t length);
+uint64_t simCycleCount(Simulator* sim);
+uint64_t simInstructionCount(Simulator* sim);
+bool simIsHalted(Simulator* sim);
+void simReadUnitStats(Simulator* sim, ScoreboardStats* out);
+void simReadActivity(Simulator* sim, ActivityCounts out);
+void simReadPipeline5Stats(Simulator* sim, Pipeline5Stats* out);
+
+// Prints the register and memory dumps to stdout
+void simPrintState(Simulator* sim);
+
+#endif // SIMULATOR_H
@@ -0,0 +1,26 @@
+#ifndef STATE_H
+#define STATE_H
+
+#include <stdint.h>
+#include "registers.h"
+#include "memory.h"
+#include "pipeline.h"
+#include "pipeline5.h"
+
+// ======================= Simulator State Snapshot =======================
+// A complete copy of the machine: architectural state plus pipeline latches.
+typedef struct {
+    int8_t registers[REGISTER_COUNT];
+    uint8_t sreg;
+    uint16_t pc;
+    uint16_t instructionMemory[INSTRUCTION_MEMORY_SIZE];
+    int8_t dataMemory[DATA_MEMORY_SIZE];
+    PipelineSnapshot pipeline;
+    Pipeline5Snapshot pipeline5;
+} SimState;
+
+// Function Prototypes
+void captureState(SimState* state);
+void restoreState(const SimState* state);
+
+#endif // STATE_H
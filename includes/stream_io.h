@@ -0,0 +1,60 @@
+#ifndef STREAM_IO_H
+#define STREAM_IO_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "platform.h"
+
+// ======================= Streaming I/O Device =======================
+// Memory-mapped input and output FIFOs for guest programs. When a device is
+// attached, the top three addresses LDR/STR can reach become ports instead of
+// data memory:
+//   STREAM_IN_READY  (LDR) 1 if an input byte is available, 0 at end of input
+//   STREAM_IN_DATA   (LDR) removes and returns the next input byte (0 at end)
+//   STREAM_OUT_DATA  (STR) appends a byte to the output
+// Other accesses to the ports read 0 and ignore writes; the data memory bytes
+// behind them are left untouched. The host side moves data in large blocks:
+// the input buffer is refilled with one read() when the guest empties it and
+// the output buffer is written out when full and on flushStreamOutput().
+//
+// Port accesses have side effects, so the block engine, the cycle estimator
+// and the scheduler (which may reorder loads) must not run while a device is
+// attached. The stream positions are not part of SimState.
+
+#define STREAM_IN_READY  61
+#define STREAM_IN_DATA   62
+#define STREAM_OUT_DATA  63
+#define STREAM_IO_BASE   STREAM_IN_READY
+
+#define STREAM_BUFFER_SIZE (64 * 1024)
+
+typedef struct {
+    int inFd;                      // -1 for no input (always at end)
+    int outFd;                     // -1 to discard output
+    size_t inPos;
+    size_t inLength;
+    size_t outLength;
+    bool inEnd;                    // read() returned 0 or failed
+    bool outError;                 // A write() failed; later output is dropped
+    uint64_t bytesIn;              // Bytes the guest consumed
+    uint64_t bytesOut;             // Bytes the guest produced
+    uint8_t inBuffer[STREAM_BUFFER_SIZE];
+    uint8_t outBuffer[STREAM_BUFFER_SIZE];
+} StreamDevice;
+
+// Device the resident machine's ports map to, or NULL
+extern SIM_THREAD_LOCAL StreamDevice* activeStreams;
+
+static inline bool isStreamPort(uint16_t address) {
+    return activeStreams && address >= STREAM_IO_BASE && address <= STREAM_OUT_DATA;
+}
+
+// Function Prototypes
+void initStreamDevice(StreamDevice* device, int inFd, int outFd);
+void setStreamDevice(StreamDevice* device);
+int8_t readStreamPort(uint16_t address);
+void writeStreamPort(uint16_t address, int8_t value);
+int flushStreamOutput(StreamDevice* device);
+
+#endif // STREAM_IO_H
@@ -0,0 +1,52 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "platform.h"
+
+// ======================= Retirement Records =======================
+// One executed instruction as seen by a timing model: where it came from,
+// which registers it read and wrote, its data address and branch outcome.
+#define RETIRE_NO_REG        0xFF   // Unused dest/src slot
+
+#define RETIRE_TAKEN         0x01   // Branch redirected fetch
+#define RETIRE_MEM_READ      0x02   // LDR
+#define RETIRE_MEM_WRITE     0x04   // STR
+#define RETIRE_WRITES_SREG   0x08   // Arithmetic/logic op updated flags
+
+typedef struct {
+    uint16_t pc;
+    uint8_t opcode;
+    uint8_t flags;         // RETIRE_* bits
+    uint8_t dest;          // Register written, or RETIRE_NO_REG
+    uint8_t src1;          // Registers read, or RETIRE_NO_REG
+    uint8_t src2;
+    uint8_t address;       // Data address of LDR/STR
+} RetireRecord;
+
+// ======================= Simulator Events =======================
+// Optional callbacks invoked as the simulator runs. Any member may be NULL.
+typedef struct {
+    void (*onLog)(void* user, const char* text);                          // Verbose trace text
+    void (*onRegisterWrite)(void* user, uint8_t regNum, int8_t value);    // GPR written
+    void (*onMemoryWrite)(void* user, uint16_t address, int8_t value);    // Data memory written
+    void (*onBranch)(void* user, uint16_t targetPC);                      // Branch taken
+    void (*onHalt)(void* user);                                           // HALT fetched
+    void (*onRetire)(void* user, const RetireRecord* record);             // Instruction executed
+    void* user;                                                           // Passed back to every callback
+} SimCallbacks;
+
+// ======================= Trace State =======================
+extern SIM_THREAD_LOCAL SimCallbacks traceCallbacks;
+extern SIM_THREAD_LOCAL bool traceActive;   // True when trace text goes anywhere (stdout or onLog)
+
+// ======================= Trace Function Prototypes =======================
+void setTraceStdout(bool enabled);
+void setTraceCallbacks(const SimCallbacks* callbacks);
+void tracef(const char* format, ...);
+
+// Trace text is only formatted when someone is listening
+#define TRACE(...) do { if (traceActive) tracef(__VA_ARGS__); } while (0)
+
+#endif // TRACE_H
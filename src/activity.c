@@ -0,0 +1,132 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../includes/activity.h"
+#include "../includes/isa.h"
+
+// ================== Counter Storage ==================
+
+// Both NULL while counting is off, which is the default for every thread
+SIM_THREAD_LOCAL uint64_t* activityRow = NULL;
+SIM_THREAD_LOCAL uint64_t (*activityTable)[ACT_COUNT] = NULL;
+
+static const char* EVENT_NAMES[ACT_COUNT] = {
+    "fetch", "decode", "reg-read", "reg-write", "add", "sub", "mul",
+    "logic", "shift", "mem-read", "mem-write", "toggle"
+};
+
+// Illustrative energies for a small 8-bit core; calibrate with --energy-table
+static const double DEFAULT_PICOJOULES[ACT_COUNT] = {
+    2.0,    // fetch: 16-bit instruction SRAM read
+    0.4,    // decode
+    0.6,    // reg-read
+    0.8,    // reg-write
+    0.5,    // add
+    0.5,    // sub
+    2.5,    // mul
+    0.2,    // logic
+    0.3,    // shift
+    2.5,    // mem-read
+    3.0,    // mem-write
+    0.02    // toggle (per bit)
+};
+
+/**
+ * Makes table the counters of this thread's resident machine.
+ * @param table: ACTIVITY_ROWS rows, or NULL to stop counting.
+ */
+void setActivityTable(uint64_t (*table)[ACT_COUNT]) {
+    activityTable = table;
+    activityRow = table ? table[ACTIVITY_NO_PC] : NULL;
+}
+
+/**
+ * Clears the resident counters, if counting is on.
+ */
+void initActivity() {
+    if (activityTable) {
+        memset(activityTable, 0, sizeof(ActivityCounts));
+    }
+    setActivityTable(activityTable);
+}
+
+// ================== Energy Tables ==================
+
+void defaultEnergyTable(EnergyTable* energy) {
+    memcpy(energy->picojoules, DEFAULT_PICOJOULES, sizeof(energy->picojoules));
+}
+
+/**
+ * Parses "event=picojoules,..." (e.g. "fetch=1.5,mul=4") over the defaults.
+ * @return: 0 on success, -1 on an unknown event or a negative energy.
+ */
+int parseEnergyTable(const char* text, EnergyTable* energy) {
+    defaultEnergyTable(energy);
+
+    char buffer[256];
+    snprintf(buffer, sizeof(buffer), "%s", text);
+    for (char* item = strtok(buffer, ","); item; item = strtok(NULL, ",")) {
+        char* value = strchr(item, '=');
+        if (!value) return -1;
+        *value++ = '\0';
+        double picojoules = atof(value);
+        int event = 0;
+        while (event < ACT_COUNT && strcmp(EVENT_NAMES[event], item) != 0) event++;
+        if (event == ACT_COUNT || picojoules < 0) return -1;
+        energy->picojoules[event] = picojoules;
+    }
+    return 0;
+}
+
+static double rowEnergy(const uint64_t* row, const EnergyTable* energy) {
+    double total = 0;
+    for (int event = 0; event < ACT_COUNT; event++) {
+        total += row[event] * energy->picojoules[event];
+    }
+    return total;
+}
+
+// ================== Reporting ==================
+
+/**
+ * Prints the per-event totals and the energy of every instruction address.
+ * @param counts: Activity table read from the simulator.
+ * @param program: Instruction memory, for naming each address.
+ * @param instructions: Executed instructions, for the per-instruction average.
+ */
+void printEnergyReport(const ActivityCounts counts, const uint16_t* program, const EnergyTable* energy,
+                       uint64_t instructions) {
+    uint64_t totals[ACT_COUNT] = {0};
+    for (int row = 0; row < ACTIVITY_ROWS; row++) {
+        for (int event = 0; event < ACT_COUNT; event++) {
+            totals[event] += counts[row][event];
+        }
+    }
+    double total = rowEnergy(totals, energy);
+
+    printf("\n===== Activity and Energy =====\n");
+    printf("%-10s %14s %10s %14s %8s\n", "event", "count", "pJ/event", "energy pJ", "share");
+    for (int event = 0; event < ACT_COUNT; event++) {
+        double picojoules = totals[event] * energy->picojoules[event];
+        printf("%-10s %14llu %10.3f %14.1f %7.1f%%\n", EVENT_NAMES[event], (unsigned long long)totals[event],
+               energy->picojoules[event], picojoules, total > 0 ? 100.0 * picojoules / total : 0.0);
+    }
+    printf("Total: %.1f pJ (%.2f pJ per instruction)\n", total,
+           instructions ? total / instructions : 0.0);
+
+    printf("\n===== Energy by PC =====\n");
+    printf("%-6s %-8s %8s %10s %14s %8s\n", "PC", "word", "op", "fetches", "energy pJ", "share");
+    for (int pc = 0; pc < ACTIVITY_ROWS; pc++) {
+        double picojoules = rowEnergy(counts[pc], energy);
+        if (picojoules == 0) continue;
+        if (pc == ACTIVITY_NO_PC) {
+            printf("%-6s %-8s %8s %10s %14.1f %7.1f%%\n", "-", "", "other", "",
+                   picojoules, total > 0 ? 100.0 * picojoules / total : 0.0);
+            continue;
+        }
+        const char* name = program[pc] == 0xFFFF ? "HALT" : ISA_TABLE[program[pc] >> 12].name;
+        printf("%-6d 0x%04X   %8s %10llu %14.1f %7.1f%%\n", pc, program[pc], name ? name : "?",
+               (unsigned long long)counts[pc][ACT_FETCH], picojoules,
+               total > 0 ? 100.0 * picojoules / total : 0.0);
+    }
+}
@@ -0,0 +1,4 @@
+#include "../includes/alu_tables.h"
+
+// Table contents are generated; regenerate with `make alu-tables`
+#include "alu_tables.inc"
@@ -0,0 +1,304 @@
+#include <stdlib.h>
+#include "../includes/block_cache.h"
+#include "../includes/isa.h"
+#include "../includes/alu_tables.h"
+#include "../includes/trace.h"
+#include "../includes/profile.h"
+
+// ================== Translated Blocks ==================
+
+typedef struct BlockOp BlockOp;
+typedef void (*OpHandler)(const BlockOp* op);
+
+struct BlockOp {
+    OpHandler run;
+    uint8_t r1;            // Destination register
+    uint8_t r2;            // Source register, data address or shift amount
+    int8_t imm;            // MOVI value or ANDI mask
+    uint8_t fusedR1;       // ADD operands of a fused MOVI+ADD / LDR+ADD pair
+    uint8_t fusedR2;
+};
+
+typedef enum {
+    EXIT_FALLTHROUGH,      // Next PC is end + 1 (HALT word or a split block)
+    EXIT_BEQZ,
+    EXIT_BR
+} BlockExit;
+
+typedef struct {
+    uint16_t start;
+    uint16_t end;          // Last guest instruction, including the branch
+    uint16_t length;       // Guest instructions in the block
+    uint8_t exit;
+    uint8_t r1;            // Branch operands
+    uint8_t r2;
+    uint16_t target;       // BEQZ target
+    uint8_t preBranchWrite;    // Written by the instruction before the branch, or NO_REGISTER
+    uint8_t lastWrite;         // Written by the last instruction (FALLTHROUGH blocks)
+    uint16_t opCount;
+    BlockOp ops[];
+} Block;
+
+// Cache keyed by start PC; it describes this thread's resident instruction memory
+static SIM_THREAD_LOCAL Block* blockCache[INSTRUCTION_MEMORY_SIZE];
+static SIM_THREAD_LOCAL int cachedBlocks = 0;
+
+// ================== Handlers ==================
+
+static inline void aluPair(const uint16_t* table, uint8_t mask, uint8_t r1, uint8_t r2) {
+    uint16_t entry = aluPairEntry(table, registers[r1], registers[r2]);
+    registers[r1] = aluResult(entry);
+    SREG = aluMergeFlags(SREG, entry, mask);
+}
+
+static inline void aluShift(const uint16_t* table, uint8_t r1, uint8_t amount) {
+    uint16_t entry = aluShiftEntry(table, registers[r1], amount);
+    registers[r1] = aluResult(entry);
+    SREG = aluMergeFlags(SREG, entry, ALU_FLAGS_NZ);
+}
+
+static void opADD(const BlockOp* op) { aluPair(ALU_ADD_TABLE, ALU_FLAGS_ADD, op->r1, op->r2); }
+static void opSUB(const BlockOp* op) { aluPair(ALU_SUB_TABLE, ALU_FLAGS_SUB, op->r1, op->r2); }
+static void opMUL(const BlockOp* op) { aluPair(ALU_MUL_TABLE, ALU_FLAGS_NZ, op->r1, op->r2); }
+static void opEOR(const BlockOp* op) { aluPair(ALU_EOR_TABLE, ALU_FLAGS_NZ, op->r1, op->r2); }
+static void opSAL(const BlockOp* op) { aluShift(ALU_SAL_TABLE, op->r1, op->r2); }
+static void opSAR(const BlockOp* op) { aluShift(ALU_SAR_TABLE, op->r1, op->r2); }
+
+static void opANDI(const BlockOp* op) {
+    uint16_t entry = aluPairEntry(ALU_ANDI_TABLE, op->imm, registers[op->r1]);
+    registers[op->r1] = aluResult(entry);
+    SREG = aluMergeFlags(SREG, entry, ALU_FLAGS_NZ);
+}
+
+static void opMOVI(const BlockOp* op) {
+    registers[op->r1] = op->imm;
+}
+
+static void opLDR(const BlockOp* op) {
+    registers[op->r1] = dataMemory[op->r2];
+}
+
+static void opSTR(const BlockOp* op) {
+    dataMemory[op->r2] = registers[op->r1];
+    if (traceCallbacks.onMemoryWrite) {
+        traceCallbacks.onMemoryWrite(traceCallbacks.user, op->r2, registers[op->r1]);
+    }
+}
+
+// Fused pairs: the first instruction, then ADD fusedR1 fusedR2
+static void opMOVI_ADD(const BlockOp* op) {
+    registers[op->r1] = op->imm;
+    aluPair(ALU_ADD_TABLE, ALU_FLAGS_ADD, op->fusedR1, op->fusedR2);
+}
+
+static void opLDR_ADD(const BlockOp* op) {
+    registers[op->r1] = dataMemory[op->r2];
+    aluPair(ALU_ADD_TABLE, ALU_FLAGS_ADD, op->fusedR1, op->fusedR2);
+}
+
+// Handler per opcode, op<NAME> for every instruction in ISA_INSTRUCTIONS.
+// Branches end a block (see translateBlock) instead of running as ops, and
+// reserved opcodes have no handler.
+#define opBEQZ NULL
+#define opBR NULL
+#define BLOCK_HANDLER_ENTRY(name, opcode, operand, flags, unit) [opcode] = op##name,
+static const OpHandler BLOCK_HANDLERS[OPCODE_COUNT] = {
+    ISA_INSTRUCTIONS(BLOCK_HANDLER_ENTRY)
+};
+#undef opBEQZ
+#undef opBR
+
+// ================== Translation ==================
+
+static bool isHaltAt(uint16_t pc) {
+    return pc >= INSTRUCTION_MEMORY_SIZE || instructionMemory[pc] == 0xFFFF;
+}
+
+/**
+ * Decodes the straight-line run starting at start (an instruction, not a
+ * HALT) into a block. Decoding matches decodeStage: LDR/STR addresses are
+ * unsigned, every other immediate is sign-extended from 6 bits.
+ * @return: The new block, or NULL if out of memory.
+ */
+static Block* translateBlock(uint16_t start) {
+    Block* block = malloc(sizeof(Block) + MAX_BLOCK_LENGTH * sizeof(BlockOp));
+    if (!block) return NULL;
+    block->start = start;
+    block->length = 0;
+    block->exit = EXIT_FALLTHROUGH;
+    block->preBranchWrite = NO_REGISTER;
+    block->lastWrite = NO_REGISTER;
+    block->opCount = 0;
+
+    for (uint16_t pc = start; !isHaltAt(pc) && block->length < MAX_BLOCK_LENGTH; pc++) {
+        uint16_t word = instructionMemory[pc];
+        uint8_t opcode = (word >> 12) & 0x0F;
+        uint8_t r1 = (word >> 6) & 0x3F;
+        uint8_t operand = word & 0x3F;
+        int8_t imm = (int8_t)((operand & 0x20) ? (operand | 0xC0) : operand);
+
+        block->end = pc;
+        block->length++;
+        if (ISA_TABLE[opcode].flags & ISA_BRANCH) {
+            block->exit = opcode == OP_BEQZ ? EXIT_BEQZ : EXIT_BR;
+            block->r1 = r1;
+            block->r2 = operand;
+            block->target = (uint16_t)(pc + 1 + imm);
+            block->preBranchWrite = block->lastWrite;
+            block->lastWrite = NO_REGISTER;
+            break;
+        }
+        block->lastWrite = ISA_TABLE[opcode].flags & ISA_WRITES_R1 ? r1 : NO_REGISTER;
+
+        // Fold an ADD into the MOVI or LDR right before it
+        BlockOp* prev = block->opCount ? &block->ops[block->opCount - 1] : NULL;
+        if (opcode == OP_ADD && prev && (prev->run == opMOVI || prev->run == opLDR)) {
+            prev->run = prev->run == opMOVI ? opMOVI_ADD : opLDR_ADD;
+            prev->fusedR1 = r1;
+            prev->fusedR2 = operand;
+            continue;
+        }
+
+        if (!BLOCK_HANDLERS[opcode]) continue;   // Reserved opcodes take a cycle and do nothing
+        BlockOp* op = &block->ops[block->opCount];
+        op->run = BLOCK_HANDLERS[opcode];
+        op->r1 = r1;
+        op->r2 = ISA_TABLE[opcode].operand == OPERAND_SHIFT ? (uint8_t)imm : operand;
+        op->imm = imm;
+        block->opCount++;
+    }
+
+    Block* shrunk = realloc(block, sizeof(Block) + block->opCount * sizeof(BlockOp));
+    return shrunk ? shrunk : block;
+}
+
+static Block* lookupBlock(uint16_t pc) {
+    Block* block = blockCache[pc];
+    if (!block) {
+        block = translateBlock(pc);
+        if (block) {
+            blockCache[pc] = block;
+            cachedBlocks++;
+        }
+    }
+    return block;
+}
+
+// ================== Public Interface ==================
+
+/**
+ * Executes translated blocks from a pipeline position, advancing it by the
+ * IF/ID/EX timing (one cycle per instruction, the ID-stage interlock, two
+ * bubbles per taken branch or one when branches resolve in ID), until the
+ * next PC is a HALT or the next block could end past cycleLimit.
+ * Memory-write and branch callbacks are produced.
+ * @param position: Where to start; receives where execution stopped.
+ * @param cycleLimit: Absolute cycle count not to exceed, 0 for unlimited.
+ * @param counts: Receives the instructions, taken branches and interlocks run.
+ * @return: true if execution stopped at a HALT.
+ */
+bool followBlocks(PipelinePosition* position, uint64_t cycleLimit, BlockRunCounts* counts) {
+    PipelinePosition pos = *position;
+    bool inDecode = isBranchInDecode();
+    counts->instructions = 0;
+    counts->takenBranches = 0;
+    counts->interlocks = 0;
+
+    while (!isHaltAt(pos.pc)) {
+        Block* block = lookupBlock(pos.pc);
+        if (!block) break;
+
+        // A branch resolved in ID waits a cycle for a source written right before it
+        uint64_t interlock = 0;
+        if (inDecode && block->exit != EXIT_FALLTHROUGH) {
+            uint8_t before = block->length > 1 ? block->preBranchWrite : pos.lastWrite;
+            if (before != NO_REGISTER &&
+                (before == block->r1 || (block->exit == EXIT_BR && before == block->r2))) {
+                interlock = 1;
+            }
+        }
+        if (cycleLimit && pos.nextExecute + block->length - 1 + interlock > cycleLimit) break;
+
+        for (const BlockOp* op = block->ops; op < block->ops + block->opCount; op++) {
+            op->run(op);
+        }
+        counts->instructions += block->length;
+        counts->interlocks += interlock;
+        pos.nextExecute += block->length + interlock;
+        pos.pc = block->end + 1;
+        pos.streaming = true;
+        pos.lastWrite = block->lastWrite;
+
+        bool taken = false;
+        if (block->exit == EXIT_BEQZ && registers[block->r1] == 0) {
+            pos.pc = block->target;
+            taken = true;
+        } else if (block->exit == EXIT_BR) {
+            pos.pc = (registers[block->r1] << 8) | registers[block->r2];
+            taken = true;
+        }
+        if (taken) {
+            // Fetch bubbles before the target executes
+            counts->takenBranches++;
+            pos.nextExecute += inDecode ? 1 : 2;
+            pos.streaming = false;
+            if (traceCallbacks.onBranch) {
+                traceCallbacks.onBranch(traceCallbacks.user, pos.pc);
+            }
+        }
+    }
+
+    *position = pos;
+    return isHaltAt(pos.pc);
+}
+
+/**
+ * Runs translated blocks from the pipeline's current position until the
+ * program reaches a HALT or the next block could end past cycleLimit, then
+ * rebuilds the pipeline at that point. The caller finishes the remaining
+ * cycles (draining after HALT, or up to the limit) with pipelineCycle().
+ * Trace text and register-write callbacks are not produced; memory-write
+ * and branch callbacks are.
+ * @param cycleLimit: Absolute cycle count not to exceed, 0 for unlimited.
+ */
+void runBlocks(uint64_t cycleLimit) {
+    PipelinePosition pos;
+    BlockRunCounts counts;
+    if (!savePipelinePosition(&pos)) return;
+    PROFILE_BEGIN(blocks);
+
+    followBlocks(&pos, cycleLimit, &counts);
+    if (counts.instructions > 0) {
+        restorePipelinePosition(&pos, counts.instructions);
+    }
+    PROFILE_END(blocks, PROFILE_BLOCKS);
+}
+
+/**
+ * Drops every cached block that contains the given instruction address.
+ * Called on each write to instruction memory.
+ */
+void invalidateBlocks(uint16_t address) {
+    if (cachedBlocks == 0 || address >= INSTRUCTION_MEMORY_SIZE) return;
+    int first = address >= MAX_BLOCK_LENGTH ? address - MAX_BLOCK_LENGTH + 1 : 0;
+    for (int start = first; start <= address; start++) {
+        Block* block = blockCache[start];
+        if (block && block->end >= address) {
+            free(block);
+            blockCache[start] = NULL;
+            cachedBlocks--;
+        }
+    }
+}
+
+/**
+ * Drops every cached block, e.g. when a different program becomes resident.
+ */
+void flushBlockCache() {
+    if (cachedBlocks == 0) return;
+    for (int i = 0; i < INSTRUCTION_MEMORY_SIZE; i++) {
+        free(blockCache[i]);
+        blockCache[i] = NULL;
+    }
+    cachedBlocks = 0;
+}
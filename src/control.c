@@ -1,5 +1,6 @@
 #include <stdio.h>
 #include "../includes/control.h"
+#include "../includes/trace.h"
 
 
 // ================== Pipeline Control Mechanisms ==================
@@ -11,7 +12,7 @@ void flushPipeline() {
     IF_ID.valid = false;
     ID_EX.valid = false;
     isStalled = true;
-    printf("[CONTROL] Pipeline flushed\n");
+    TRACE("[CONTROL] Pipeline flushed\n");
 }
 
 /**
@@ -21,7 +22,22 @@ void flushPipeline() {
 void handleBranchFlush(uint16_t targetPC) {
     flushPipeline();
     setPC(targetPC);
-    printf("[CONTROL] Branch Taken -> Redirecting to %d (0x%04X)\n", targetPC, (uint16_t)targetPC);
+    if (traceCallbacks.onBranch) {
+        traceCallbacks.onBranch(traceCallbacks.user, targetPC);
+    }
+    TRACE("[CONTROL] Branch Taken -> Redirecting to %d (0x%04X)\n", targetPC, (uint16_t)targetPC);
+}
+
+/**
+ * Redirects fetch to a branch target resolved in ID. Only the instruction
+ * behind the branch is squashed; the branch itself moves on to EX.
+ * @param targetPC: The target address to branch to.
+ */
+void redirectFetch(uint16_t targetPC) {
+    IF_ID.valid = false;
+    isStalled = true;
+    setPC(targetPC);
+    TRACE("[CONTROL] Branch Resolved in ID -> Redirecting to %d (0x%04X)\n", targetPC, (uint16_t)targetPC);
 }
 
 /**
@@ -29,5 +45,5 @@ void handleBranchFlush(uint16_t targetPC) {
  */
 void stallPipeline() {
     IF_ID.valid = false;
-    printf("[CONTROL] Pipeline Stalled for One Cycle\n");
+    TRACE("[CONTROL] Pipeline Stalled for One Cycle\n");
 }
@@ -0,0 +1,52 @@
+#include "../includes/estimator.h"
+#include "../includes/block_cache.h"
+#include "../includes/pipeline.h"
+
+/**
+ * Runs the resident program functionally from the pipeline's current
+ * position and computes the cycle count the IF/ID/EX model would reach.
+ * Registers and memory end in the program's final state; the pipeline
+ * latches and counters are not touched.
+ * @param cycleLimit: Absolute cycle count not to exceed, 0 for unlimited.
+ * @param estimate: Receives the counts and the cycle total.
+ * @return: false if multi-cycle latencies are set (not modelled).
+ */
+bool estimateCycles(uint64_t cycleLimit, CycleEstimate* estimate) {
+    if (hasMultiCycleOps()) return false;
+
+    PipelinePosition start;
+    if (!savePipelinePosition(&start)) {
+        // Already drained
+        estimate->halted = true;
+        estimate->cycles = getCycleCount();
+        estimate->instructions = getInstructionCount();
+        estimate->takenBranches = 0;
+        estimate->interlocks = 0;
+        estimate->lastTaken = false;
+        return true;
+    }
+
+    PipelinePosition end = start;
+    BlockRunCounts counts;
+    estimate->halted = followBlocks(&end, cycleLimit, &counts);
+    estimate->instructions = getInstructionCount() + counts.instructions;
+    estimate->takenBranches = counts.takenBranches;
+    estimate->interlocks = counts.interlocks;
+    estimate->lastTaken = counts.instructions > 0 && !end.streaming;
+
+    uint64_t penalty = isBranchInDecode() ? 1 : 2;
+    if (!estimate->halted) {
+        // Cycles up to the last instruction that ran, without its bubbles
+        estimate->cycles = end.nextExecute - 1 - (estimate->lastTaken ? penalty : 0);
+    } else if (counts.instructions == 0) {
+        // HALT is fetched in the first free cycle and nothing is in flight
+        estimate->cycles = start.nextExecute - 2;
+    } else {
+        // start.nextExecute - 1 covers the fill; then one cycle per
+        // instruction plus the flush bubbles and ID interlocks
+        estimate->cycles = start.nextExecute - 1 + counts.instructions +
+                           penalty * counts.takenBranches + counts.interlocks -
+                           (estimate->lastTaken ? 1 : 0);
+    }
+    return true;
+}
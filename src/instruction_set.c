@@ -1,6 +1,10 @@
 #include <stdio.h>
 #include "../includes/instruction_set.h"
+#include "../includes/alu_tables.h"
+#include "../includes/trace.h"
+#include "../includes/activity.h"
 
+#ifndef USE_ALU_TABLES
 // Helper function to update flags according to specifications
 static void update_flags(int8_t result, int8_t a, int8_t b, int is_add) {
     // Clear all flags first
@@ -36,32 +40,56 @@ static void update_flags(int8_t result, int8_t a, int8_t b, int is_add) {
     clearFlag(SIGN_FLAG);
     if (getFlag(NEGATIVE_FLAG) ^ getFlag(OVERFLOW_FLAG)) setFlag(SIGN_FLAG);
 }
+#endif
 
 // ================== R-Format Instructions ==================
 
 void execute_ADD(uint8_t r1, uint8_t r2) {
+    COUNT_ACTIVITY(ACT_ALU_ADD);
     int8_t a = readRegister(r1);
     int8_t b = readRegister(r2);
+#ifdef USE_ALU_TABLES
+    uint16_t entry = aluPairEntry(ALU_ADD_TABLE, a, b);
+    int8_t result = aluResult(entry);
+    writeRegister(r1, result);
+    SREG = aluMergeFlags(SREG, entry, ALU_FLAGS_ADD);
+#else
     int8_t result = a + b;
     writeRegister(r1, result);
     update_flags(result, a, b, 1);  // 1 indicates addition
-    printf("[EX] ADD R%d = R%d + R%d -> %d (0x%02X) (SREG: %d 0x%02X)\n", 
+#endif
+    TRACE("[EX] ADD R%d = R%d + R%d -> %d (0x%02X) (SREG: %d 0x%02X)\n", 
            r1, r1, r2, result, (uint8_t)result, SREG, SREG);
 }
 
 void execute_SUB(uint8_t r1, uint8_t r2) {
+    COUNT_ACTIVITY(ACT_ALU_SUB);
     int8_t a = readRegister(r1);
     int8_t b = readRegister(r2);
+#ifdef USE_ALU_TABLES
+    uint16_t entry = aluPairEntry(ALU_SUB_TABLE, a, b);
+    int8_t result = aluResult(entry);
+    writeRegister(r1, result);
+    SREG = aluMergeFlags(SREG, entry, ALU_FLAGS_SUB);
+#else
     int8_t result = a - b;
     writeRegister(r1, result);
     update_flags(result, a, b, 0);  // 0 indicates subtraction
-    printf("[EX] SUB R%d = R%d - R%d -> %d (0x%02X) (SREG: 0x%02X)\n", 
+#endif
+    TRACE("[EX] SUB R%d = R%d - R%d -> %d (0x%02X) (SREG: 0x%02X)\n", 
            r1, r1, r2, result, (uint8_t)result, SREG);
 }
 
 void execute_MUL(uint8_t r1, uint8_t r2) {
+    COUNT_ACTIVITY(ACT_ALU_MUL);
     int8_t a = readRegister(r1);
     int8_t b = readRegister(r2);
+#ifdef USE_ALU_TABLES
+    uint16_t entry = aluPairEntry(ALU_MUL_TABLE, a, b);
+    int8_t result = aluResult(entry);
+    writeRegister(r1, result);
+    SREG = aluMergeFlags(SREG, entry, ALU_FLAGS_NZ);
+#else
     int16_t result = (int16_t)a * (int16_t)b;
 
     writeRegister(r1, (int8_t)result);
@@ -70,14 +98,22 @@ void execute_MUL(uint8_t r1, uint8_t r2) {
     clearFlag(ZERO_FLAG);
     if (result < 0) setFlag(NEGATIVE_FLAG);
     if (result == 0) setFlag(ZERO_FLAG);
+#endif
 
-    printf("[EX] MUL R%d = R%d * R%d -> %d (0x%02X) (SREG: 0x%02X)\n", 
+    TRACE("[EX] MUL R%d = R%d * R%d -> %d (0x%02X) (SREG: 0x%02X)\n", 
            r1, r1, r2, (int8_t)result, (uint8_t)result, SREG);
 }
 
 void execute_EOR(uint8_t r1, uint8_t r2) {
+    COUNT_ACTIVITY(ACT_ALU_LOGIC);
     int8_t a = readRegister(r1);
     int8_t b = readRegister(r2);
+#ifdef USE_ALU_TABLES
+    uint16_t entry = aluPairEntry(ALU_EOR_TABLE, a, b);
+    int8_t result = aluResult(entry);
+    writeRegister(r1, result);
+    SREG = aluMergeFlags(SREG, entry, ALU_FLAGS_NZ);
+#else
     int8_t result = a ^ b;
     writeRegister(r1, result);
     // For logical operations, only set N, Z, and S flags
@@ -85,33 +121,41 @@ void execute_EOR(uint8_t r1, uint8_t r2) {
     clearFlag(ZERO_FLAG);
     if (result < 0) setFlag(NEGATIVE_FLAG);
     if (result == 0) setFlag(ZERO_FLAG);
-    printf("[EX] EOR R%d = R%d ^ R%d -> %d (0x%02X) (SREG: 0x%02X)\n", 
+#endif
+    TRACE("[EX] EOR R%d = R%d ^ R%d -> %d (0x%02X) (SREG: 0x%02X)\n", 
            r1, r1, r2, result, (uint8_t)result, SREG);
 }
 
 void execute_BR(uint8_t r1, uint8_t r2) {
     uint16_t newPC = (readRegister(r1) << 8) | readRegister(r2);
     handleBranchFlush(newPC);
-    printf("[EX] BR PC = R%d || R%d -> %d (0x%04X)\n", r1, r2, newPC, (uint16_t)newPC);
+    TRACE("[EX] BR PC = R%d || R%d -> %d (0x%04X)\n", r1, r2, newPC, (uint16_t)newPC);
 }
 
 // ================== I-Format Instructions ==================
 
 void execute_MOVI(uint8_t r1, int8_t immediate) {
     writeRegister(r1, immediate);  // No need to cast since it's already signed
-    printf("[EX] MOVI R%d = %d (0x%02X) (SREG: 0x%02X)\n", r1, immediate, (uint8_t)immediate, SREG);
+    TRACE("[EX] MOVI R%d = %d (0x%02X) (SREG: 0x%02X)\n", r1, immediate, (uint8_t)immediate, SREG);
 }
 
-void execute_BEQZ(uint8_t r1, int8_t immediate) {
+void execute_BEQZ(uint8_t r1, int8_t immediate, uint16_t nextPC) {
     if (readRegister(r1) == 0) {
-        uint16_t target = PC + 1 + (int16_t)immediate;  // Cast to int16_t for proper signed addition
+        uint16_t target = nextPC + (int16_t)immediate;  // Cast to int16_t for proper signed addition
         handleBranchFlush(target);
-        printf("[EX] BEQZ R%d == 0 -> PC = PC + 1 + %d (0x%02X)\n", r1, immediate, (uint8_t)immediate);
+        TRACE("[EX] BEQZ R%d == 0 -> PC = PC + 1 + %d (0x%02X)\n", r1, immediate, (uint8_t)immediate);
     }
 }
 
 void execute_ANDI(uint8_t r1, int8_t immediate) {
+    COUNT_ACTIVITY(ACT_ALU_LOGIC);
     int8_t a = readRegister(r1);
+#ifdef USE_ALU_TABLES
+    uint16_t entry = aluPairEntry(ALU_ANDI_TABLE, immediate, a);
+    int8_t result = aluResult(entry);
+    writeRegister(r1, result);
+    SREG = aluMergeFlags(SREG, entry, ALU_FLAGS_NZ);
+#else
     int8_t result = a & immediate;  // No need to cast since it's already signed
     writeRegister(r1, result);
     // For logical operations, only set N, Z, and S flags
@@ -119,12 +163,20 @@ void execute_ANDI(uint8_t r1, int8_t immediate) {
     clearFlag(ZERO_FLAG);
     if (result < 0) setFlag(NEGATIVE_FLAG);
     if (result == 0) setFlag(ZERO_FLAG);
-    printf("[EX] ANDI R%d = R%d & %d (0x%02X) -> %d (0x%02X) (SREG: 0x%02X)\n", 
+#endif
+    TRACE("[EX] ANDI R%d = R%d & %d (0x%02X) -> %d (0x%02X) (SREG: 0x%02X)\n", 
            r1, r1, immediate, (uint8_t)immediate, result, (uint8_t)result, SREG);
 }
 
 void execute_SAL(uint8_t r1, uint8_t immediate) {
+    COUNT_ACTIVITY(ACT_ALU_SHIFT);
     int8_t a = readRegister(r1);
+#ifdef USE_ALU_TABLES
+    uint16_t entry = aluShiftEntry(ALU_SAL_TABLE, a, immediate);
+    int8_t result = aluResult(entry);
+    writeRegister(r1, result);
+    SREG = aluMergeFlags(SREG, entry, ALU_FLAGS_NZ);
+#else
     int8_t result;
     if (immediate >= 8) {
         result = 0;
@@ -137,12 +189,20 @@ void execute_SAL(uint8_t r1, uint8_t immediate) {
     clearFlag(ZERO_FLAG);
     if (result < 0) setFlag(NEGATIVE_FLAG);
     if (result == 0) setFlag(ZERO_FLAG);
-    printf("[EX] SAL R%d = R%d << %d -> %d (0x%02X) (SREG: 0x%02X)\n", 
+#endif
+    TRACE("[EX] SAL R%d = R%d << %d -> %d (0x%02X) (SREG: 0x%02X)\n", 
            r1, r1, immediate, result, (uint8_t)result, SREG);
 }
 
 void execute_SAR(uint8_t r1, uint8_t immediate) {
+    COUNT_ACTIVITY(ACT_ALU_SHIFT);
     int8_t a = readRegister(r1);
+#ifdef USE_ALU_TABLES
+    uint16_t entry = aluShiftEntry(ALU_SAR_TABLE, a, immediate);
+    int8_t result = aluResult(entry);
+    writeRegister(r1, result);
+    SREG = aluMergeFlags(SREG, entry, ALU_FLAGS_NZ);
+#else
     int8_t result;
     if (immediate >= 8) {
         // Arithmetic shift preserves the sign bit
@@ -157,18 +217,19 @@ void execute_SAR(uint8_t r1, uint8_t immediate) {
     clearFlag(ZERO_FLAG);
     if (result < 0) setFlag(NEGATIVE_FLAG);
     if (result == 0) setFlag(ZERO_FLAG);
-    printf("[EX] SAR R%d = R%d >> %d -> %d (0x%02X) (SREG: 0x%02X)\n", 
+#endif
+    TRACE("[EX] SAR R%d = R%d >> %d -> %d (0x%02X) (SREG: 0x%02X)\n", 
            r1, r1, immediate, result, (uint8_t)result, SREG);
 }
 
 void execute_LDR(uint8_t r1, uint8_t address) {
     uint8_t value = readFromMemory((uint16_t)address, 1);
     writeRegister(r1, (int8_t)value);  // Cast to signed
-    printf("[EX] LDR R%d = MEM[%d (0x%02X)] -> %d (0x%02X)\n", r1, address, (uint8_t)address, (int8_t)value, value);
+    TRACE("[EX] LDR R%d = MEM[%d (0x%02X)] -> %d (0x%02X)\n", r1, address, (uint8_t)address, (int8_t)value, value);
 }
 
 void execute_STR(uint8_t r1, uint8_t address) {
     int8_t value = readRegister(r1);
     writeToMemory((uint16_t)address, (uint8_t)value, 1);  // Cast to unsigned for memory
-    printf("[EX] STR MEM[%d (0x%02X)] = R%d -> %d (0x%02X)\n", address, (uint8_t)address, r1, value, (uint8_t)value);
+    TRACE("[EX] STR MEM[%d (0x%02X)] = R%d -> %d (0x%02X)\n", address, (uint8_t)address, r1, value, (uint8_t)value);
 }
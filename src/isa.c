@@ -0,0 +1,22 @@
+#include <string.h>
+#include "../includes/isa.h"
+
+// ================== Instruction Table ==================
+#define ISA_TABLE_ENTRY(name, opcode, operand, flags, unit) [opcode] = {#name, OPERAND_##operand, flags},
+
+const InstructionInfo ISA_TABLE[OPCODE_COUNT] = {
+    ISA_INSTRUCTIONS(ISA_TABLE_ENTRY)
+};
+
+/**
+ * Looks up an assembler mnemonic.
+ * @return: The opcode, or -1 if name is not an instruction.
+ */
+int findOpcode(const char* name) {
+    for (int opcode = 0; opcode < OPCODE_COUNT; opcode++) {
+        if (ISA_TABLE[opcode].name && strcmp(ISA_TABLE[opcode].name, name) == 0) {
+            return opcode;
+        }
+    }
+    return -1;
+}
@@ -1,107 +1,570 @@
-#include "../includes/pipeline.h"
-#include "../includes/memory.h"
-#include "../includes/registers.h"
-#include "../includes/parser.h"
+#include "../includes/simulator.h"
+#include "../includes/multicore.h"
+#include "../includes/retire_trace.h"
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
 
-int main() {
-    // Initialize system components
-    initMemory();
-    initRegisters();
-    initPipeline();
+#define DEFAULT_CACHE_MB 64
 
-    // Create a test program file
-    FILE* testFile = fopen("test_program.txt", "w");
-    if (!testFile) {
-        printf("Error: Could not create test program file\n");
+static void printUsage(const char* exe) {
+    printf("Usage: %s [program.txt] [--max-cycles N] [--quiet] [--engine pipeline|blocks]\n"
+           "       [--record-trace FILE] [--cores N [--quantum Q] [--core-id-reg R]]\n"
+           "       [--schedule] [--schedule-model SPEC] [--branch-stage ex|id] [--compare-branch-stages]\n"
+           "       [--latency SPEC] [--estimate] [--validate-estimate] [--energy] [--energy-table SPEC]\n"
+           "       [--pipeline 3|5] [--compare-pipelines] [--cache DIR [--cache-size MB]]\n"
+           "       [--data FILE[@ADDR]] [--stream-in FILE] [--stream-out FILE]\n", exe);
+    printf("  --max-cycles N  Stop after N cycles (default: run until halt)\n");
+    printf("  --quiet         Only print the final state\n");
+    printf("  --engine E      pipeline (cycle by cycle, default) or blocks (translated\n"
+           "                  basic blocks; used when --quiet or --cores is given)\n");
+    printf("  --record-trace FILE  Write a retirement trace for tools/trace_replay\n");
+    printf("  --cores N       Run N guest cores over one shared data memory\n");
+    printf("  --quantum Q     Cycles between multi-core synchronizations (default %d)\n", DEFAULT_QUANTUM);
+    printf("  --core-id-reg R Preload each core's number into register R\n");
+    printf("  --schedule      Reorder each basic block to hide interlock stalls\n");
+    printf("  --schedule-model SPEC  Latencies to schedule for (implies --schedule),\n"
+           "                  e.g. alu=1,mul=2,load=2,branch=1 (the defaults)\n");
+    printf("  --branch-stage S  Resolve BEQZ/BR in ex (two bubbles, default) or id (one)\n");
+    printf("  --compare-branch-stages  Run the program with each branch stage and\n"
+           "                  print cycles and CPI side by side\n");
+    printf("  --latency SPEC  EX cycles per opcode, e.g. MUL=3,LDR=2 (others take 1);\n"
+           "                  dependents stall in ID and unit occupancy is reported\n");
+    printf("  --estimate      Print the analytic cycle estimate instead of simulating\n");
+    printf("  --validate-estimate  Check the estimate against the cycle-by-cycle\n"
+           "                  pipeline; exits with 1 on a mismatch\n");
+    printf("  --energy        Report activity counts and dynamic energy per event and per PC\n"
+           "                  (runs the pipeline engine)\n");
+    printf("  --energy-table SPEC  Picojoules per event (implies --energy),\n"
+           "                  e.g. fetch=1.5,mul=4,toggle=0.05\n");
+    printf("  --pipeline D    3 (IF/ID/EX, default) or 5 (IF/ID/EX/MEM/WB with forwarding)\n");
+    printf("  --compare-pipelines  Run the program on both pipeline models and print\n"
+           "                  cycles and CPI side by side\n");
+    printf("  --cache DIR     Reuse the final state of an identical earlier run from the\n"
+           "                  result store in DIR, or store this run's\n");
+    printf("  --cache-size MB Size limit of the result store (default %d)\n", DEFAULT_CACHE_MB);
+    printf("  --data FILE[@ADDR]  Copy a raw binary file into data memory at ADDR (default 0)\n");
+    printf("  --stream-in FILE  Input the guest reads through the I/O ports (- for stdin)\n");
+    printf("  --stream-out FILE Where the guest's port output goes\n");
+}
+
+static void countBranch(void* user, uint16_t targetPC) {
+    (void)targetPC;
+    (*(uint64_t*)user)++;
+}
+
+// Runs the loaded program once per branch-resolution stage and prints the comparison
+static int compareBranchStages(Simulator* sim, uint64_t maxCycles, const MultiCoreConfig* config,
+                               SimPipelineDepth depth) {
+    static uint16_t image[INSTRUCTION_MEMORY_SIZE];
+    static const char* NAMES[] = {"EX", "ID"};
+    double baseCpi = 0;
+
+    simReadInstructionMemory(sim, 0, image, INSTRUCTION_MEMORY_SIZE);
+    printf("%-6s %12s %14s %8s %10s %10s\n", "stage", "cycles", "instructions", "CPI", "taken", "CPI vs EX");
+    for (int stage = SIM_BRANCH_IN_EX; stage <= SIM_BRANCH_IN_ID; stage++) {
+        uint64_t taken = 0;
+        SimCallbacks callbacks = {0};
+        callbacks.onBranch = countBranch;
+        callbacks.user = &taken;
+        Simulator* run = simCreate(&callbacks);
+        if (!run) {
+            printf("Error: Could not create simulator\n");
+            return 1;
+        }
+        simSetEngine(run, config->engine);
+        simSetPipelineDepth(run, depth);
+        simSetBranchStage(run, (SimBranchStage)stage);
+        for (int op = 0; op < OPCODE_COUNT; op++) {
+            simSetLatency(run, (uint8_t)op, config->latencies[op]);
+        }
+        simLoadImage(run, image, INSTRUCTION_MEMORY_SIZE);
+        SimStopReason reason = simRun(run, maxCycles);
+
+        uint64_t cycles = simCycleCount(run);
+        uint64_t instructions = simInstructionCount(run);
+        double cpi = instructions ? (double)cycles / instructions : 0.0;
+        if (stage == SIM_BRANCH_IN_EX) baseCpi = cpi;
+        printf("%-6s %12llu %14llu %8.3f %10llu %+9.1f%%%s\n", NAMES[stage],
+               (unsigned long long)cycles, (unsigned long long)instructions, cpi,
+               (unsigned long long)taken, baseCpi > 0 ? 100.0 * (cpi - baseCpi) / baseCpi : 0.0,
+               reason == SIM_CYCLE_LIMIT ? " (cycle limit)" : "");
+        simDestroy(run);
+    }
+    return 0;
+}
+
+static void printPipeline5Stats(const Pipeline5Stats* stats) {
+    printf("Five-stage: %llu load-use stalls, %llu branch stalls, %llu flushes, "
+           "%llu EX/MEM and %llu MEM/WB forwards\n",
+           (unsigned long long)stats->loadUseStalls, (unsigned long long)stats->branchStalls,
+           (unsigned long long)stats->takenBranches, (unsigned long long)stats->forwardsExMem,
+           (unsigned long long)stats->forwardsMemWb);
+}
+
+// Runs the loaded program on the three- and five-stage models and prints the comparison
+static int comparePipelineDepths(Simulator* sim, uint64_t maxCycles, const MultiCoreConfig* config) {
+    static uint16_t image[INSTRUCTION_MEMORY_SIZE];
+    static const char* NAMES[] = {"3-stage", "5-stage"};
+    static int8_t baseData[DATA_MEMORY_SIZE];
+    static int8_t data[DATA_MEMORY_SIZE];
+    int8_t baseRegisters[REGISTER_COUNT];
+    uint8_t baseSREG = 0;
+    double baseCpi = 0;
+    Pipeline5Stats stats = {0};
+
+    simReadInstructionMemory(sim, 0, image, INSTRUCTION_MEMORY_SIZE);
+    printf("%-8s %12s %14s %8s %10s %s\n", "model", "cycles", "instructions", "CPI", "CPI vs 3", "state");
+    for (int depth = SIM_PIPELINE_3_STAGE; depth <= SIM_PIPELINE_5_STAGE; depth++) {
+        Simulator* run = simCreate(NULL);
+        if (!run) {
+            printf("Error: Could not create simulator\n");
+            return 1;
+        }
+        simSetEngine(run, config->engine);
+        simSetBranchStage(run, config->branchStage);
+        simSetPipelineDepth(run, (SimPipelineDepth)depth);
+        simLoadImage(run, image, INSTRUCTION_MEMORY_SIZE);
+        SimStopReason reason = simRun(run, maxCycles);
+
+        uint64_t cycles = simCycleCount(run);
+        uint64_t instructions = simInstructionCount(run);
+        double cpi = instructions ? (double)cycles / instructions : 0.0;
+        int8_t registers[REGISTER_COUNT];
+        simReadRegisters(run, registers);
+        simReadDataMemory(run, 0, data, DATA_MEMORY_SIZE);
+        uint8_t sreg = simReadSREG(run);
+        const char* state = "";
+        if (depth == SIM_PIPELINE_3_STAGE) {
+            baseCpi = cpi;
+            memcpy(baseRegisters, registers, sizeof(registers));
+            memcpy(baseData, data, sizeof(data));
+            baseSREG = sreg;
+        } else if (reason != SIM_CYCLE_LIMIT) {
+            // Runs cut off by the cycle budget stop at different points
+            bool same = memcmp(baseRegisters, registers, sizeof(registers)) == 0 &&
+                        memcmp(baseData, data, sizeof(data)) == 0 && baseSREG == sreg;
+            state = same ? "same" : "DIFFERS";
+        }
+        if (depth == SIM_PIPELINE_5_STAGE) {
+            simReadPipeline5Stats(run, &stats);
+        }
+        printf("%-8s %12llu %14llu %8.3f %+9.1f%% %s%s\n", NAMES[depth],
+               (unsigned long long)cycles, (unsigned long long)instructions, cpi,
+               baseCpi > 0 ? 100.0 * (cpi - baseCpi) / baseCpi : 0.0, state,
+               reason == SIM_CYCLE_LIMIT ? "(cycle limit)" : "");
+        simDestroy(run);
+    }
+    printPipeline5Stats(&stats);
+    return 0;
+}
+
+// Keeps the five-stage counters with a run's result, so a cached run can report them
+static void storePipeline5Stats(Simulator* sim, SimPipelineDepth depth, CachedResult* result) {
+    if (depth != SIM_PIPELINE_5_STAGE) return;
+    Pipeline5Stats stats;
+    simReadPipeline5Stats(sim, &stats);
+    result->counters[0] = stats.loadUseStalls;
+    result->counters[1] = stats.branchStalls;
+    result->counters[2] = stats.takenBranches;
+    result->counters[3] = stats.forwardsExMem;
+    result->counters[4] = stats.forwardsMemWb;
+}
+
+// Takes the run's result from the store, or runs the program and stores it
+static bool runFromCache(Simulator* sim, uint64_t maxCycles, SimPipelineDepth depth, ResultCache* cache,
+                         CachedResult* result) {
+    RunKey key;
+    bool keyed = simRunKey(sim, maxCycles, &key);
+    if (keyed && lookupResult(cache, &key, result)) {
+        simApplyResult(sim, result);
+        printf("Result cache hit (%016llx)\n", (unsigned long long)key.hash);
+        return true;
+    }
+
+    simCaptureResult(sim, simRun(sim, maxCycles), result);
+    storePipeline5Stats(sim, depth, result);
+    if (keyed && storeResult(cache, &key, result) != 0) {
+        printf("Warning: Could not store the result in the cache\n");
+    }
+    return false;
+}
+
+static void printEstimate(const CycleEstimate* estimate) {
+    printf("Estimate: %llu cycles (%llu instructions, %llu taken branches, %llu interlocks)%s\n",
+           (unsigned long long)estimate->cycles, (unsigned long long)estimate->instructions,
+           (unsigned long long)estimate->takenBranches, (unsigned long long)estimate->interlocks,
+           estimate->halted ? "" : " - did not halt");
+}
+
+// Estimates the loaded program's cycles, optionally checking them against the pipeline model
+static int runEstimate(Simulator* sim, uint64_t maxCycles, bool validate) {
+    CycleEstimate estimate;
+    simSetVerbose(sim, false);
+    if (!simEstimateCycles(sim, maxCycles, &estimate)) {
+        printf("Error: The estimator does not model multi-cycle latencies\n");
         return 1;
     }
+    printEstimate(&estimate);
+    if (!validate) return 0;
+    if (!estimate.halted) {
+        printf("Not validated: the program did not halt within %llu cycles\n", (unsigned long long)maxCycles);
+        return 0;
+    }
 
-    // Write test instructions to file
-    // fprintf(testFile, "MOVI R1 10\n");
-    // fprintf(testFile, "MOVI R2 5\n");
-    // fprintf(testFile, "MOVI R3 -3\n");
-    // fprintf(testFile, "MOVI R4 2\n");
-    // fprintf(testFile, "MOVI R5 0\n");
+    simSetEngine(sim, SIM_ENGINE_PIPELINE);
+    simRun(sim, 0);
+    uint64_t cycles = simCycleCount(sim);
+    uint64_t instructions = simInstructionCount(sim);
+    bool match = cycles == estimate.cycles && instructions == estimate.instructions;
+    printf("Pipeline: %llu cycles (%llu instructions) - %s\n", (unsigned long long)cycles,
+           (unsigned long long)instructions, match ? "OK" : "MISMATCH");
+    return match ? 0 : 1;
+}
+
+// Opens the stream files and attaches the I/O ports; paths may be NULL
+static int attachStreams(Simulator* sim, StreamDevice* device, const char* input, const char* output) {
+    int inFd = -1, outFd = -1;
+    if (input) {
+        inFd = strcmp(input, "-") == 0 ? STDIN_FILENO : open(input, O_RDONLY);
+        if (inFd < 0) {
+            printf("Error: Could not open stream input %s\n", input);
+            return -1;
+        }
+    }
+    if (output) {
+        outFd = open(output, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (outFd < 0) {
+            printf("Error: Could not create stream output %s\n", output);
+            return -1;
+        }
+    }
+    initStreamDevice(device, inFd, outFd);
+    simAttachStreams(sim, device);
+    return 0;
+}
+
+// Runs the loaded program on several guest cores and prints the report
+static int runCores(Simulator* sim, const MultiCoreConfig* config) {
+    static uint16_t image[INSTRUCTION_MEMORY_SIZE];
+    static MultiCoreResult result;
+
+    simReadInstructionMemory(sim, 0, image, INSTRUCTION_MEMORY_SIZE);
+    if (runMultiCore(image, config, &result) != 0) {
+        printf("Error: Invalid multi-core configuration\n");
+        return 1;
+    }
+    printMultiCoreReport(config, &result);
+    return 0;
+}
 
-    // fprintf(testFile, "ADD R1 R2\n");
-    // fprintf(testFile, "SUB R1 R3\n");
-    // fprintf(testFile, "MUL R1 R4\n");
+int main(int argc, char* argv[]) {
+    const char* programFile = "program4.txt";
+    uint64_t maxCycles = 0;
+    bool quiet = false;
+    const char* traceFile = NULL;
+    MultiCoreConfig cores = {1, DEFAULT_QUANTUM, 0, -1, SIM_ENGINE_PIPELINE, SIM_BRANCH_IN_EX, {0}};
+    bool latencies = false;
+    bool schedule = false;
+    bool compareStages = false;
+    bool estimate = false;
+    bool validateEstimate = false;
+    bool energy = false;
+    SimPipelineDepth depth = SIM_PIPELINE_3_STAGE;
+    bool compareDepths = false;
+    const char* cacheDir = NULL;
+    uint64_t cacheMegabytes = DEFAULT_CACHE_MB;
+    const char* dataFile = NULL;
+    uint16_t dataAddress = 0;
+    const char* streamIn = NULL;
+    const char* streamOut = NULL;
+    EnergyTable energyTable;
+    defaultEnergyTable(&energyTable);
+    ScheduleModel scheduleModel = DEFAULT_SCHEDULE_MODEL;
 
-    // fprintf(testFile, "ANDI R1 15\n");
-    // fprintf(testFile, "EOR R1 R2\n");
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--max-cycles") == 0 && i + 1 < argc) {
+            maxCycles = strtoull(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--quiet") == 0) {
+            quiet = true;
+        } else if (strcmp(argv[i], "--engine") == 0 && i + 1 < argc) {
+            i++;
+            if (strcmp(argv[i], "blocks") == 0) {
+                cores.engine = SIM_ENGINE_BLOCKS;
+            } else if (strcmp(argv[i], "pipeline") != 0) {
+                printf("Error: Unknown engine %s\n", argv[i]);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--branch-stage") == 0 && i + 1 < argc) {
+            i++;
+            if (strcmp(argv[i], "id") == 0) {
+                cores.branchStage = SIM_BRANCH_IN_ID;
+            } else if (strcmp(argv[i], "ex") != 0) {
+                printf("Error: Unknown branch stage %s\n", argv[i]);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--latency") == 0 && i + 1 < argc) {
+            latencies = true;
+            if (parseLatencies(argv[++i], cores.latencies) != 0) {
+                printf("Error: Bad latency list \"%s\"\n", argv[i]);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--estimate") == 0) {
+            estimate = true;
+        } else if (strcmp(argv[i], "--validate-estimate") == 0) {
+            estimate = true;
+            validateEstimate = true;
+        } else if (strcmp(argv[i], "--energy") == 0) {
+            energy = true;
+        } else if (strcmp(argv[i], "--energy-table") == 0 && i + 1 < argc) {
+            energy = true;
+            if (parseEnergyTable(argv[++i], &energyTable) != 0) {
+                printf("Error: Bad energy table \"%s\"\n", argv[i]);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--pipeline") == 0 && i + 1 < argc) {
+            i++;
+            if (strcmp(argv[i], "5") == 0) {
+                depth = SIM_PIPELINE_5_STAGE;
+            } else if (strcmp(argv[i], "3") != 0) {
+                printf("Error: Unknown pipeline depth %s\n", argv[i]);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--compare-pipelines") == 0) {
+            compareDepths = true;
+        } else if (strcmp(argv[i], "--cache") == 0 && i + 1 < argc) {
+            cacheDir = argv[++i];
+        } else if (strcmp(argv[i], "--cache-size") == 0 && i + 1 < argc) {
+            cacheMegabytes = strtoull(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--data") == 0 && i + 1 < argc) {
+            // FILE@ADDR; a name containing '@' needs the address spelled out
+            static char name[512];
+            snprintf(name, sizeof(name), "%s", argv[++i]);
+            char* at = strrchr(name, '@');
+            if (at) {
+                *at = '\0';
+                dataAddress = (uint16_t)strtoul(at + 1, NULL, 0);
+            }
+            dataFile = name;
+        } else if (strcmp(argv[i], "--stream-in") == 0 && i + 1 < argc) {
+            streamIn = argv[++i];
+        } else if (strcmp(argv[i], "--stream-out") == 0 && i + 1 < argc) {
+            streamOut = argv[++i];
+        } else if (strcmp(argv[i], "--compare-branch-stages") == 0) {
+            compareStages = true;
+        } else if (strcmp(argv[i], "--record-trace") == 0 && i + 1 < argc) {
+            traceFile = argv[++i];
+        } else if (strcmp(argv[i], "--cores") == 0 && i + 1 < argc) {
+            cores.cores = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--quantum") == 0 && i + 1 < argc) {
+            cores.quantum = (uint32_t)strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--core-id-reg") == 0 && i + 1 < argc) {
+            cores.coreIdRegister = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--schedule") == 0) {
+            schedule = true;
+        } else if (strcmp(argv[i], "--schedule-model") == 0 && i + 1 < argc) {
+            schedule = true;
+            if (parseScheduleModel(argv[++i], &scheduleModel) != 0) {
+                printf("Error: Bad schedule model \"%s\"\n", argv[i]);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--help") == 0) {
+            printUsage(argv[0]);
+            return 0;
+        } else if (argv[i][0] == '-') {
+            printf("Error: Unknown option %s\n", argv[i]);
+            printUsage(argv[0]);
+            return 1;
+        } else {
+            programFile = argv[i];
+        }
+    }
 
-    // fprintf(testFile, "BEQZ R5 3\n");
-    // fprintf(testFile, "MOVI R1 30\n");
-    // fprintf(testFile, "MOVI R2 30\n");
-    // fprintf(testFile, "MOVI R3 30\n");
-    // fprintf(testFile, "MOVI R6 -8\n");
+    if (depth == SIM_PIPELINE_5_STAGE || compareDepths) {
+        if (cores.cores != 1 || latencies || estimate) {
+            printf("Error: The five-stage pipeline needs a single core, single-cycle units and no estimate\n");
+            return 1;
+        }
+    }
+    if (energy && cores.cores != 1) {
+        printf("Error: --energy needs a single core\n");
+        return 1;
+    }
 
-    // // fprintf(testFile, "MOVI R9 1\n");
-    // // fprintf(testFile, "MOVI R10 1\n");
-    // // fprintf(testFile, "BR R9 R10\n");
+    bool streams = streamIn || streamOut;
+    if ((dataFile || streams) && (cores.cores != 1 || compareStages || compareDepths)) {
+        printf("Error: --data and --stream-in/--stream-out need a single core and a single run\n");
+        return 1;
+    }
+    if (streams && (estimate || cacheDir)) {
+        printf("Error: --stream-in/--stream-out cannot be estimated or cached\n");
+        return 1;
+    }
 
-    // fprintf(testFile, "SAL R6 1\n");
-    // fprintf(testFile, "SAR R6 2\n");
+    // A cached run replays no events and keeps no unit or activity counters
+    if (cacheDir && (cores.cores != 1 || latencies || energy || traceFile)) {
+        printf("Error: --cache needs a single core and no --latency, --energy or --record-trace\n");
+        return 1;
+    }
 
-    // fprintf(testFile, "MOVI R7 31\n");
-    // fprintf(testFile, "STR R7 50\n");
-    // fprintf(testFile, "LDR R8 50\n");
+    static RetireTraceWriter writer;
+    SimCallbacks callbacks = {0};
+    if (traceFile) {
+        if (cores.cores != 1) {
+            printf("Error: --record-trace needs a single core\n");
+            return 1;
+        }
+        if (openRetireTrace(&writer, traceFile) != 0) {
+            printf("Error: Could not create trace file %s\n", traceFile);
+            return 1;
+        }
+        callbacks.onRetire = recordRetirement;
+        callbacks.user = &writer;
+    }
 
-    // fprintf(testFile, "MOVI R1 31\n");
-    // fprintf(testFile, "MOVI R2 1\n");
-    // fprintf(testFile, "MUL R1 R2\n");
-    fclose(testFile);
+    Simulator* sim = simCreate(&callbacks);
+    if (!sim) {
+        printf("Error: Could not create simulator\n");
+        return 1;
+    }
+    // The per-cycle trace of several cores would interleave; multi-core runs report at the end
+    simSetVerbose(sim, !quiet && cores.cores == 1);
+    simSetEngine(sim, cores.engine);
+    simSetBranchStage(sim, cores.branchStage);
+    simSetPipelineDepth(sim, depth);
+    simSetActivityCounting(sim, energy);
+    static StreamDevice device;
+    if (streams && attachStreams(sim, &device, streamIn, streamOut) != 0) {
+        simDestroy(sim);
+        return 1;
+    }
+    for (int op = 0; op < OPCODE_COUNT; op++) {
+        simSetLatency(sim, (uint8_t)op, cores.latencies[op]);
+    }
 
     // Parse and load the program
-    printf("\n=== Loading Program ===\n");
-    int instructionCount = parseInstructionFile("program4.txt");
+    if (!quiet) printf("\n=== Loading Program ===\n");
+    int instructionCount = simLoadFile(sim, programFile);
     if (instructionCount < 0) {
-        printf("Error: Failed to parse program\n");
+        printf("Error: Failed to parse program %s\n", programFile);
+        simDestroy(sim);
         return 1;
     }
-    printf("Successfully loaded %d instructions\n", instructionCount);
-
-    // Set initial register values for testing
-    // printf("\n=== Setting Initial Register Values ===\n");
-    // writeRegister(1, 0);   // R1 = 0
-    // writeRegister(2, 9);  // R2 = 20
-    // setFlag(ZERO_FLAG);
-    // writeRegister(3, 30);  // R3 = 30
-    // writeRegister(4, 0);   // R4 = 0 (for BEQZ test)
-    // writeRegister(5, 8);   // R5 = 8 (for shift test)
-    // writeRegister(6, -8);  // R6 = -8 (for arithmetic shift test)
-    // writeRegister(7, 0);   // R7 = 0 (for load test)
-    // writeRegister(8, 42);  // R8 = 42 (for store test)
-    // writeRegister(9, 10);  // R9 = 10 (for branch test)
-    // writeRegister(10, 1); // R10 = 10 (for branch test)
-    // writeRegister(11, 2); // R11 = 10 (for branch test)
-    // writeRegister(12, 3); // R12 = 10 (for branch test)
-    // writeRegister(13, 4); // R13 = 10 (for branch test)
-    // writeRegister(14, 8); // R14 = 10 (for branch test)
-    // writeRegister(15, 7); // R15 = 10 (for branch test)
-    // writeRegister(16, 6); // R16 = 10 (for branch test)
-    // writeRegister(17, 5); // R17 = 10 (for branch test)
-    
-
-    // Set some initial memory values
-    // printf("\n=== Setting Initial Memory Values ===\n");
-    // writeToMemory(50, 0x55, 1);  // Data memory[10] = 0x55
-    // writeToMemory(20, 0x00, 1);  // Data memory[20] = 0x00
-
-    // Print initial state
-    printf("\n=== Initial State ===\n");
-    printRegisterDump();
-    printMemoryDump();
-
-    // Run the pipeline for a few cycles
-    printf("\n=== Running Pipeline ===\n");
-    while(pipelineCycle());
+    if (dataFile) {
+        int loaded = simLoadDataFile(sim, dataFile, dataAddress);
+        if (loaded < 0) {
+            printf("Error: Could not load %s into data memory at %u\n", dataFile, dataAddress);
+            simDestroy(sim);
+            return 1;
+        }
+        if (!quiet) printf("Loaded %d bytes of data at %u\n", loaded, dataAddress);
+    }
+    if (schedule) {
+        ScheduleReport report;
+        simSchedule(sim, &scheduleModel, &report);
+        if (!report.applied) {
+            printf("Scheduling skipped: %s\n", report.reason);
+        } else {
+            printf("Scheduled %d of %d blocks (%d instructions moved), predicted stalls %llu -> %llu\n",
+                   report.rescheduled, report.blocks, report.moved,
+                   (unsigned long long)report.stallsBefore, (unsigned long long)report.stallsAfter);
+        }
+    }
+    if (estimate) {
+        int status = runEstimate(sim, maxCycles, validateEstimate);
+        simDestroy(sim);
+        return status;
+    }
+    if (compareDepths) {
+        int status = comparePipelineDepths(sim, maxCycles, &cores);
+        simDestroy(sim);
+        return status;
+    }
+    if (compareStages) {
+        int status = compareBranchStages(sim, maxCycles, &cores, depth);
+        simDestroy(sim);
+        return status;
+    }
+    if (cores.cores != 1) {
+        cores.maxCycles = maxCycles;
+        int status = runCores(sim, &cores);
+        simDestroy(sim);
+        return status;
+    }
+    if (!quiet) {
+        printf("Successfully loaded %d instructions\n", instructionCount);
+
+        // Print initial state
+        printf("\n=== Initial State ===\n");
+        simPrintState(sim);
+
+        printf("\n=== Running Pipeline ===\n");
+    }
+
+    static CachedResult outcome;
+    bool cached = false;
+    ResultCache* cache = NULL;
+    if (cacheDir) {
+        cache = openResultCache(cacheDir, cacheMegabytes << 20);
+        if (!cache) {
+            printf("Error: Could not open result cache %s\n", cacheDir);
+            simDestroy(sim);
+            return 1;
+        }
+    }
+    if (cache) {
+        cached = runFromCache(sim, maxCycles, depth, cache, &outcome);
+        closeResultCache(cache);
+    } else {
+        simCaptureResult(sim, simRun(sim, maxCycles), &outcome);
+        storePipeline5Stats(sim, depth, &outcome);
+    }
+    if (outcome.reason == SIM_CYCLE_LIMIT) {
+        printf("\nSIMULATION STOPPED: MAXIMUM CYCLES (%llu)\n", (unsigned long long)maxCycles);
+    }
 
     // Print final state
-    printf("\n=== Final State ===\n");
-    printRegisterDump();
-    printMemoryDump();
+    printf("\n=== Final State%s ===\n", cached ? " (cached)" : "");
+    simPrintState(sim);
+    printf("Cycles: %llu | Instructions: %llu\n",
+           (unsigned long long)outcome.cycles, (unsigned long long)outcome.instructions);
+    if (latencies) {
+        ScoreboardStats units;
+        simReadUnitStats(sim, &units);
+        printScoreboardReport(&units, simCycleCount(sim));
+    }
+    if (depth == SIM_PIPELINE_5_STAGE) {
+        Pipeline5Stats stats = {outcome.counters[0], outcome.counters[1], outcome.counters[2],
+                                outcome.counters[3], outcome.counters[4]};
+        printPipeline5Stats(&stats);
+    }
+    if (energy) {
+        static ActivityCounts activity;
+        static uint16_t image[INSTRUCTION_MEMORY_SIZE];
+        simReadActivity(sim, activity);
+        simReadInstructionMemory(sim, 0, image, INSTRUCTION_MEMORY_SIZE);
+        printEnergyReport(activity, image, &energyTable, simInstructionCount(sim));
+    }
+
+    if (streams) {
+        if (flushStreamOutput(&device) != 0) {
+            printf("Error: Could not write stream output %s\n", streamOut);
+        }
+        printf("Streams: %llu bytes in, %llu bytes out\n", (unsigned long long)device.bytesIn,
+               (unsigned long long)device.bytesOut);
+    }
+
+    if (traceFile) {
+        if (closeRetireTrace(&writer, simCycleCount(sim)) != 0) {
+            printf("Error: Could not write trace file %s\n", traceFile);
+        } else {
+            printf("Recorded %llu retirements to %s\n",
+                   (unsigned long long)writer.header.recordCount, traceFile);
+        }
+    }
 
+    simDestroy(sim);
     return 0;
 }
@@ -1,10 +1,18 @@
 #include <stdio.h>
 #include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include "../includes/memory.h"
+#include "../includes/trace.h"
+#include "../includes/block_cache.h"
+#include "../includes/activity.h"
+#include "../includes/stream_io.h"
 
 // Memory Arrays
-uint16_t instructionMemory[INSTRUCTION_MEMORY_SIZE];
-int8_t dataMemory[DATA_MEMORY_SIZE];
+SIM_THREAD_LOCAL uint16_t instructionMemory[INSTRUCTION_MEMORY_SIZE];
+SIM_THREAD_LOCAL int8_t dataMemory[DATA_MEMORY_SIZE];
 
 /**
  * Initializes the Instruction and Data memory to zero.
@@ -15,6 +23,7 @@ void initMemory() {
     }
     // memset(instructionMemory, 0, sizeof(instructionMemory));
     memset(dataMemory, 0, sizeof(dataMemory));
+    flushBlockCache();
 }
 
 /**
@@ -25,18 +34,26 @@ void initMemory() {
  */
 void writeToMemory(uint16_t address, uint16_t value, int isDataMemory) {
     if (isDataMemory) {
-        if (address < DATA_MEMORY_SIZE) {
+        if (isStreamPort(address)) {
+            COUNT_ACTIVITY(ACT_MEM_WRITE);
+            writeStreamPort(address, (int8_t)value);
+        } else if (address < DATA_MEMORY_SIZE) {
+            COUNT_ACTIVITY(ACT_MEM_WRITE);
             dataMemory[address] = (int8_t)value;
-            printf("[MEM] Data Memory [0x%04X] = %d (0x%02X)\n", address, value, (uint8_t)value);
+            TRACE("[MEM] Data Memory [0x%04X] = %d (0x%02X)\n", address, value, (uint8_t)value);
+            if (traceCallbacks.onMemoryWrite) {
+                traceCallbacks.onMemoryWrite(traceCallbacks.user, address, (int8_t)value);
+            }
         } else {
-            printf("Error: Data Memory Address out of bounds\n");
+            TRACE("Error: Data Memory Address out of bounds\n");
         }
     } else {
         if (address < INSTRUCTION_MEMORY_SIZE) {
             instructionMemory[address] = value;
-            printf("[MEM] Instruction Memory [0x%04X] = %d (0x%04X)\n", address, value, (uint16_t)value);
+            invalidateBlocks(address);
+            TRACE("[MEM] Instruction Memory [0x%04X] = %d (0x%04X)\n", address, value, (uint16_t)value);
         } else {
-            printf("Error: Instruction Memory Address out of bounds\n");
+            TRACE("Error: Instruction Memory Address out of bounds\n");
         }
     }
 }
@@ -49,22 +66,58 @@ void writeToMemory(uint16_t address, uint16_t value, int isDataMemory) {
  */
 uint16_t readFromMemory(uint16_t address, int isDataMemory) {
     if (isDataMemory) {
-        if (address < DATA_MEMORY_SIZE) {
+        if (isStreamPort(address)) {
+            COUNT_ACTIVITY(ACT_MEM_READ);
+            return (uint8_t)readStreamPort(address);
+        } else if (address < DATA_MEMORY_SIZE) {
+            COUNT_ACTIVITY(ACT_MEM_READ);
             return dataMemory[address];
         } else {
-            printf("Error: Data Memory Address out of bounds\n");
+            TRACE("Error: Data Memory Address out of bounds\n");
             return 0;
         }
     } else {
         if (address < INSTRUCTION_MEMORY_SIZE) {
+            COUNT_ACTIVITY(ACT_FETCH);
             return instructionMemory[address];
         } else {
-            printf("Error: Instruction Memory Address out of bounds\n");
+            TRACE("Error: Instruction Memory Address out of bounds\n");
             return 0;
         }
     }
 }
 
+/**
+ * Copies a raw binary file into data memory in one step, without tracing or
+ * write events.
+ * @param filename: File whose bytes become data memory from address on.
+ * @param address: First data memory address to fill.
+ * @return: Number of bytes loaded, or -1 if the file cannot be read or does
+ *          not fit.
+ */
+int loadDataMemoryFile(const char* filename, uint16_t address) {
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0) return -1;
+    struct stat info;
+    if (fstat(fd, &info) != 0 || address > DATA_MEMORY_SIZE ||
+        info.st_size > (off_t)(DATA_MEMORY_SIZE - address)) {
+        close(fd);
+        return -1;
+    }
+    size_t length = (size_t)info.st_size;
+    if (length > 0) {
+        void* mapped = mmap(NULL, length, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapped == MAP_FAILED) {
+            close(fd);
+            return -1;
+        }
+        memcpy(&dataMemory[address], mapped, length);
+        munmap(mapped, length);
+    }
+    close(fd);
+    return (int)length;
+}
+
 /**
  * Prints a memory dump for debugging.
  */
@@ -0,0 +1,219 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include "../includes/multicore.h"
+#include "../includes/simulator.h"
+
+// ================== Shared Run State ==================
+
+typedef struct {
+    uint16_t address;
+    int8_t value;
+} StoreRecord;
+
+typedef struct MultiCoreRun MultiCoreRun;
+
+typedef struct {
+    int id;
+    MultiCoreRun* run;
+    StoreRecord* stores;       // STRs issued during the current quantum
+    uint32_t storeCount;
+    bool finished;             // Halted or out of cycles
+} CoreContext;
+
+struct MultiCoreRun {
+    const uint16_t* image;
+    const MultiCoreConfig* config;
+    MultiCoreResult* result;
+    int8_t sharedMemory[DATA_MEMORY_SIZE];
+    CoreContext cores[MAX_CORES];
+    pthread_barrier_t barrier;
+    bool done;
+};
+
+static double nowSeconds() {
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+// onMemoryWrite callback: buffer the store until the quantum boundary
+static void logStore(void* user, uint16_t address, int8_t value) {
+    CoreContext* core = user;
+    StoreRecord* record = &core->stores[core->storeCount++];
+    record->address = address;
+    record->value = value;
+}
+
+/**
+ * Runs by exactly one thread between the two quantum barriers: publishes
+ * every core's buffered stores in core order and decides whether to stop.
+ */
+static void commitQuantum(MultiCoreRun* run) {
+    bool allFinished = true;
+    for (int c = 0; c < run->config->cores; c++) {
+        CoreContext* core = &run->cores[c];
+        for (uint32_t i = 0; i < core->storeCount; i++) {
+            run->sharedMemory[core->stores[i].address] = core->stores[i].value;
+        }
+        core->storeCount = 0;
+        allFinished = allFinished && core->finished;
+    }
+    run->result->quanta++;
+    run->done = allFinished;
+}
+
+static void* coreMain(void* arg) {
+    CoreContext* core = arg;
+    MultiCoreRun* run = core->run;
+    const MultiCoreConfig* config = run->config;
+    CoreResult* out = &run->result->cores[core->id];
+
+    SimCallbacks callbacks = {0};
+    callbacks.onMemoryWrite = logStore;
+    callbacks.user = core;
+    Simulator* sim = simCreate(&callbacks);
+    simSetEngine(sim, config->engine);
+    simSetBranchStage(sim, config->branchStage);
+    for (int op = 0; op < OPCODE_COUNT; op++) {
+        simSetLatency(sim, (uint8_t)op, config->latencies[op]);
+    }
+    simLoadImage(sim, run->image, INSTRUCTION_MEMORY_SIZE);
+    if (config->coreIdRegister >= 0) {
+        simWriteRegister(sim, (uint8_t)config->coreIdRegister, (int8_t)core->id);
+    }
+
+    while (!run->done) {
+        if (!core->finished) {
+            double start = nowSeconds();
+            uint64_t budget = config->quantum;
+            if (config->maxCycles) {
+                uint64_t left = config->maxCycles - simCycleCount(sim);
+                if (left < budget) budget = left;
+            }
+            simWriteDataMemory(sim, 0, run->sharedMemory, DATA_MEMORY_SIZE);
+            simRun(sim, budget);
+            core->finished = simIsHalted(sim) ||
+                             (config->maxCycles && simCycleCount(sim) >= config->maxCycles);
+            out->busySeconds += nowSeconds() - start;
+        }
+
+        if (pthread_barrier_wait(&run->barrier) == PTHREAD_BARRIER_SERIAL_THREAD) {
+            commitQuantum(run);
+        }
+        pthread_barrier_wait(&run->barrier);
+    }
+
+    simReadRegisters(sim, out->registers);
+    out->sreg = simReadSREG(sim);
+    out->pc = simReadPC(sim);
+    out->cycles = simCycleCount(sim);
+    out->instructions = simInstructionCount(sim);
+    out->halted = simIsHalted(sim);
+    simDestroy(sim);
+    return NULL;
+}
+
+// ================== Public Interface ==================
+
+/**
+ * Runs a program on several guest cores sharing one data memory.
+ * @param image: Assembled instruction memory, loaded into every core.
+ * @param config: Core count, quantum, cycle budget and core-id register.
+ * @param result: Receives per-core state and the final shared memory.
+ * @return: 0 on success, -1 on invalid configuration or thread failure.
+ */
+int runMultiCore(const uint16_t image[INSTRUCTION_MEMORY_SIZE], const MultiCoreConfig* config,
+                 MultiCoreResult* result) {
+    if (config->cores < 1 || config->cores > MAX_CORES || config->quantum == 0 ||
+        config->coreIdRegister >= REGISTER_COUNT) {
+        return -1;
+    }
+
+    MultiCoreRun* run = calloc(1, sizeof(MultiCoreRun));
+    if (!run) return -1;
+    memset(result, 0, sizeof(*result));
+    run->image = image;
+    run->config = config;
+    run->result = result;
+
+    pthread_t threads[MAX_CORES];
+    int started = 0;
+    int status = 0;
+    pthread_barrier_init(&run->barrier, NULL, (unsigned)config->cores);
+
+    for (int c = 0; c < config->cores; c++) {
+        run->cores[c].id = c;
+        run->cores[c].run = run;
+        run->cores[c].stores = malloc(config->quantum * sizeof(StoreRecord));
+        if (!run->cores[c].stores) status = -1;
+    }
+
+    double start = nowSeconds();
+    if (status == 0) {
+        for (; started < config->cores; started++) {
+            if (pthread_create(&threads[started], NULL, coreMain, &run->cores[started]) != 0) {
+                status = -1;
+                break;
+            }
+        }
+    }
+    // A partially started run would wait at the barrier forever
+    if (status != 0 && started > 0) {
+        fprintf(stderr, "Error: Could not start all core threads\n");
+        exit(1);
+    }
+    for (int c = 0; c < started; c++) {
+        pthread_join(threads[c], NULL);
+    }
+    result->wallSeconds = nowSeconds() - start;
+    memcpy(result->dataMemory, run->sharedMemory, sizeof(result->dataMemory));
+
+    for (int c = 0; c < config->cores; c++) {
+        free(run->cores[c].stores);
+    }
+    pthread_barrier_destroy(&run->barrier);
+    free(run);
+    return status;
+}
+
+/**
+ * Prints per-core final state and throughput, then the aggregate figures
+ * and the shared data memory.
+ */
+void printMultiCoreReport(const MultiCoreConfig* config, const MultiCoreResult* result) {
+    uint64_t totalInstructions = 0;
+    uint64_t totalCycles = 0;
+
+    printf("===== Multi-Core Report (%d cores, quantum %u, %llu quanta) =====\n",
+           config->cores, config->quantum, (unsigned long long)result->quanta);
+    for (int c = 0; c < config->cores; c++) {
+        const CoreResult* core = &result->cores[c];
+        double mips = core->busySeconds > 0 ? core->instructions / core->busySeconds / 1e6 : 0.0;
+        printf("Core %d: %s | PC: %d (0x%04X) | SREG: 0x%02X | Cycles: %llu | Instructions: %llu | "
+               "IPC: %.3f | %.2f MIPS\n",
+               c, core->halted ? "halted" : "stopped", core->pc, core->pc, core->sreg,
+               (unsigned long long)core->cycles, (unsigned long long)core->instructions,
+               core->cycles ? (double)core->instructions / core->cycles : 0.0, mips);
+        for (int r = 0; r < REGISTER_COUNT; r++) {
+            if (core->registers[r] != 0) {
+                printf("    R%d: %d (0x%02X)\n", r, core->registers[r], (uint8_t)core->registers[r]);
+            }
+        }
+        totalInstructions += core->instructions;
+        totalCycles += core->cycles;
+    }
+    printf("Aggregate: %llu instructions, %llu core-cycles in %.3f s (%.2f MIPS)\n",
+           (unsigned long long)totalInstructions, (unsigned long long)totalCycles, result->wallSeconds,
+           result->wallSeconds > 0 ? totalInstructions / result->wallSeconds / 1e6 : 0.0);
+
+    printf("\n===== Shared Data Memory Dump =====\n");
+    for (int i = 0; i < DATA_MEMORY_SIZE; ++i) {
+        if (result->dataMemory[i] != 0) {
+            printf("Addr [%d] : %d (0x%02X)\n", i, result->dataMemory[i], (uint8_t)result->dataMemory[i]);
+        }
+    }
+    printf("\n");
+}
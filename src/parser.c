@@ -1,42 +1,12 @@
 #include "../includes/parser.h"
+#include "../includes/isa.h"
+#include "../includes/trace.h"
+#include "../includes/profile.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <ctype.h>
 
-// Operation to opcode mapping
-typedef struct {
-    const char* op;
-    uint8_t opcode;
-} OpcodeMap;
-
-static const OpcodeMap OPCODE_TABLE[] = {
-    {"ADD",  0},
-    {"SUB",  1},
-    {"MUL",  2},
-    {"MOVI", 3},
-    {"BEQZ", 4},
-    {"ANDI", 5},
-    {"EOR",  6},
-    {"BR",   7},
-    {"SAL",  8},  // Shift instruction
-    {"SAR",  9},  // Shift instruction
-    {"LDR",  10},
-    {"STR",  11}
-};
-
-#define OPCODE_TABLE_SIZE (sizeof(OPCODE_TABLE) / sizeof(OpcodeMap))
-
-// Helper function to get opcode and instruction type
-static uint8_t getOpcode(const char* op) {
-    for (size_t i = 0; i < OPCODE_TABLE_SIZE; i++) {
-        if (strcmp(op, OPCODE_TABLE[i].op) == 0) {
-            return OPCODE_TABLE[i].opcode;
-        }
-    }
-    return 0xFF; // Invalid opcode
-}
-
 // Helper function to parse register number (e.g., "R5" -> 5)
 static uint8_t parseRegister(const char* reg) {
     if (reg[0] == 'R') {
@@ -55,20 +25,20 @@ static int8_t parseImmediate(const char* imm, int is_shift) {
     if (is_shift == 1) {
         // For shift instructions, ensure positive value and within bounds
         if (value < 0 || value > 7) {  // Shift amount should be 0-7
-            printf("Error: Shift amount must be between 0 and 7\n");
+            TRACE("Error: Shift amount must be between 0 and 7\n");
             return 0xFF;  // Invalid shift amount
         }
         return (uint8_t)value;
     } else if (is_shift == 0) {
         // For other instructions, allow signed values (-32 to 31)
         if (value < -32 || value > 31) {
-            printf("Error: Immediate value must be between -32 and 31\n");
+            TRACE("Error: Immediate value must be between -32 and 31\n");
             return 0xFF;  // Invalid immediate
         }
         return (int8_t)value;
     } else{
         if (value < 0 || value > 63) {
-            printf("Error: Immediate value must be between 0 and 63\n");
+            TRACE("Error: Immediate value must be between 0 and 63\n");
             return 0xFF;  // Invalid immediate
         }
         return (uint8_t)value;
@@ -104,43 +74,33 @@ static uint16_t parseInstructionLine(const char* line) {
     
     // Parse the instruction components
     if (sscanf(line, "%s %s %s", op, op1, op2) != 3) {
-        printf("Error: Invalid instruction format: %s\n", line);
+        TRACE("Error: Invalid instruction format: %s\n", line);
         return 0;
     }
     
-    // Get opcode and check if it's a shift instruction
-    //int is_shift = 0;
-    uint8_t opcode = getOpcode(op);
-    if (opcode == 0xFF) {
-        printf("Error: Invalid operation: %s\n", op);
+    int opcode = findOpcode(op);
+    if (opcode < 0) {
+        TRACE("Error: Invalid operation: %s\n", op);
         return 0;
     }
     
-    // Parse operands based on instruction type
-    uint8_t operand1;
+    // Parse operands based on the instruction's operand kind
+    uint8_t operand1 = parseRegister(op1);
     int8_t operand2;
-    
-    // Handle different instruction formats
-    if (strcmp(op, "MOVI") == 0 || strcmp(op, "BEQZ") == 0 || 
-        strcmp(op, "ANDI") == 0) {
-        // Format: OP R1, IMM
-        operand1 = parseRegister(op1);
-        operand2 = parseImmediate(op2, 0);
-    } else if(strcmp(op, "SAL") == 0 || strcmp(op, "SAR") == 0) {
-        operand1 = parseRegister(op1);
-        operand2 = parseImmediate(op2, 1);
-    } else if (strcmp(op, "LDR") == 0 || strcmp(op, "STR") == 0) {
-        // Format: OP R1, ADDR
-        operand1 = parseRegister(op1);
-        operand2 = parseImmediate(op2, 2); 
-    } else if (strcmp(op, "BR") == 0) {
-        // Format: BR R1, R2
-        operand1 = parseRegister(op1);
-        operand2 = parseRegister(op2);
-    } else {
-        // Format: OP R1, R2 (ADD, SUB, MUL, EOR)
-        operand1 = parseRegister(op1);
-        operand2 = parseRegister(op2);
+    switch (ISA_TABLE[opcode].operand) {
+        case OPERAND_IMMEDIATE:
+        case OPERAND_OFFSET:
+            operand2 = parseImmediate(op2, 0);   // -32 to 31
+            break;
+        case OPERAND_SHIFT:
+            operand2 = parseImmediate(op2, 1);   // 0 to 7
+            break;
+        case OPERAND_ADDRESS:
+            operand2 = parseImmediate(op2, 2);   // 0 to 63
+            break;
+        default:
+            operand2 = parseRegister(op2);
+            break;
     }
     
     // Validate operands - use uint8_t for comparison since that's what parseRegister returns
@@ -148,7 +108,7 @@ static uint16_t parseInstructionLine(const char* line) {
     int8_t operand2_check = operand2;
     
     // if (operand1_check == 0xFF || (uint8_t)operand2_check == 0xFF) {
-    //     printf("Error: Invalid operands in instruction: %s\n", line);
+    //     TRACE("Error: Invalid operands in instruction: %s\n", line);
     //     return 0;
     // }
     
@@ -156,6 +116,34 @@ static uint16_t parseInstructionLine(const char* line) {
     return createInstruction(opcode, operand1, operand2);
 }
 
+// Helper function to assemble one source line into instruction memory
+static void storeInstructionLine(char* line, uint16_t* address, int* instructionCount) {
+    // Remove newline characters
+    line[strcspn(line, "\r\n")] = 0;
+
+    // Skip empty lines and comments
+    if (line[0] == '\n' || line[0] == '#' || line[0] == '\0') {
+        return;
+    }
+
+    // Parse the instruction
+    uint16_t instruction = parseInstructionLine(line);
+    if (instruction != 0) {
+        // Store in instruction memory
+        writeToMemory((*address)++, instruction, 0);
+        (*instructionCount)++;
+
+        // Print the parsed instruction for debugging
+        TRACE("[PARSER] %s -> %d (0x%04X)\n", line, instruction, (uint16_t)instruction);
+    }
+}
+
+// Helper function to terminate the program with a halt instruction (0xFFFF)
+static void storeHalt(uint16_t address) {
+    writeToMemory(address, 0xFFFF, 0);
+    TRACE("[PARSER] HALT -> 0xFFFF\n");
+}
+
 /**
  * Parses a text file containing instructions and stores them in instruction memory.
  * @param filename: Path to the input text file
@@ -164,41 +152,56 @@ static uint16_t parseInstructionLine(const char* line) {
 int parseInstructionFile(const char* filename) {
     FILE* file = fopen(filename, "r");
     if (!file) {
-        printf("Error: Could not open file %s\n", filename);
+        TRACE("Error: Could not open file %s\n", filename);
         return -1;
     }
     
     char line[256];
     int instructionCount = 0;
     uint16_t address = 0;
+    PROFILE_BEGIN(load);
     
     // Read file line by line
     while (fgets(line, sizeof(line), file)) {
-        // Remove newline character
-        line[strcspn(line, "\n")] = 0;
-        
-        // Skip empty lines and comments
-        if (line[0] == '\n' || line[0] == '#' || line[0] == '\0') {
-            continue;
-        }
-        
-        // Parse the instruction
-        uint16_t instruction = parseInstructionLine(line);
-        if (instruction != 0) {
-            // Store in instruction memory
-            writeToMemory(address++, instruction, 0);
-            instructionCount++;
-            
-            // Print the parsed instruction for debugging
-            printf("[PARSER] %s -> %d (0x%04X)\n", line, instruction, (uint16_t)instruction);
-        }
+        storeInstructionLine(line, &address, &instructionCount);
     }
     
     // Add halt instruction (0xFFFF) at the end
-    writeToMemory(address, 0xFFFF, 0);
-    printf("[PARSER] HALT -> 0xFFFF\n");
+    storeHalt(address);
     
     fclose(file);
+    PROFILE_END(load, PROFILE_LOAD);
+    return instructionCount;
+}
+
+/**
+ * Parses program source held in memory and stores it in instruction memory.
+ * @param source: Program text, one instruction per line (need not be NUL-terminated)
+ * @param length: Number of bytes in source
+ * @return: Number of instructions successfully parsed and stored
+ */
+int parseInstructionBuffer(const char* source, size_t length) {
+    char line[256];
+    int instructionCount = 0;
+    uint16_t address = 0;
+    size_t pos = 0;
+    PROFILE_BEGIN(load);
+
+    while (pos < length) {
+        size_t lineLength = 0;
+        while (pos < length && source[pos] != '\n') {
+            if (lineLength < sizeof(line) - 1) {
+                line[lineLength++] = source[pos];
+            }
+            pos++;
+        }
+        pos++;  // Skip the newline
+        line[lineLength] = '\0';
+        storeInstructionLine(line, &address, &instructionCount);
+    }
+
+    storeHalt(address);
+    PROFILE_END(load, PROFILE_LOAD);
     return instructionCount;
 }
 
@@ -1,14 +1,99 @@
 #include <stdio.h>
 #include "../includes/pipeline.h"
+#include "../includes/trace.h"
+#include "../includes/retire_trace.h"
+#include "../includes/profile.h"
+#include "../includes/isa.h"
+#include "../includes/activity.h"
 
 // ================== Pipeline Register Definitions ==================
-IF_ID_Reg IF_ID;
-ID_EX_Reg ID_EX;
+SIM_THREAD_LOCAL IF_ID_Reg IF_ID;
+SIM_THREAD_LOCAL ID_EX_Reg ID_EX;
 
-// Cycle Counter and Halt Flag
-static int cycle = 0;
-static bool isHalted = false;
-bool isStalled = false;
+// Cycle/Instruction Counters and Halt Flag
+static SIM_THREAD_LOCAL uint64_t cycle = 0;
+static SIM_THREAD_LOCAL uint64_t instructionCount = 0;
+static SIM_THREAD_LOCAL bool isHalted = false;
+SIM_THREAD_LOCAL bool isStalled = false;
+
+// Branch resolution: EX (two bubbles per taken branch) or ID (one bubble)
+static SIM_THREAD_LOCAL bool branchInDecode = false;
+// Destination of the instruction executed this cycle, for the ID-stage interlock
+static SIM_THREAD_LOCAL uint8_t lastWrittenRegister = NO_REGISTER;
+// ID/EX could not issue this cycle, so ID and IF hold their instructions
+static SIM_THREAD_LOCAL bool issueBlocked = false;
+
+// Per-opcode decode of the 6-bit operand field, expanded from the ISA table.
+// Reserved opcodes stay zero: I-format with a sign-extended operand.
+typedef struct {
+    bool registerForm;     // Operand is a register (R-format)
+    bool zeroExtend;       // Operand is a register or address, not a signed value
+} DecodeInfo;
+
+#define DECODE_ENTRY(name, opcode, operand, flags, unit) \
+    [opcode] = {OPERAND_##operand == OPERAND_REGISTER, \
+                OPERAND_##operand == OPERAND_REGISTER || OPERAND_##operand == OPERAND_ADDRESS},
+
+static const DecodeInfo DECODE_TABLE[OPCODE_COUNT] = {
+    ISA_INSTRUCTIONS(DECODE_ENTRY)
+};
+
+// Execute handler arguments by operand kind
+#define EXECUTE_ARGS_REGISTER  ID_EX.r1, ID_EX.r2
+#define EXECUTE_ARGS_IMMEDIATE ID_EX.r1, ID_EX.r2
+#define EXECUTE_ARGS_OFFSET    ID_EX.r1, ID_EX.r2, ID_EX.nextPC
+#define EXECUTE_ARGS_SHIFT     ID_EX.r1, ID_EX.r2
+#define EXECUTE_ARGS_ADDRESS   ID_EX.r1, ID_EX.r2
+
+#define EXECUTE_CASE(name, opcode, operand, flags, unit) \
+    case opcode: execute_##name(EXECUTE_ARGS_##operand); break;
+
+// IF_ID / ID_EX contents at the end of the previous cycle, for toggle counting,
+// and the instruction they belonged to
+static SIM_THREAD_LOCAL uint64_t latchBits[2];
+static SIM_THREAD_LOCAL uint16_t latchPc[2];
+// Toggle counting packs both latches every cycle, so it is off unless wanted
+static SIM_THREAD_LOCAL bool latchToggleCounting = false;
+
+// Latch contents as bit vectors, for counting the bits a clock edge flips
+static inline uint64_t packIfId(const IF_ID_Reg* latch) {
+    return (uint64_t)latch->instruction | (uint64_t)latch->nextPC << 16 | (uint64_t)latch->valid << 32;
+}
+
+static inline uint64_t packIdEx(const ID_EX_Reg* latch) {
+    return (uint64_t)latch->opcode | (uint64_t)latch->r1 << 4 | (uint64_t)latch->r2 << 10 |
+           (uint64_t)latch->isImmediate << 18 | (uint64_t)latch->nextPC << 19 |
+           (uint64_t)latch->resolved << 35 | (uint64_t)latch->taken << 36 |
+           (uint64_t)latch->target << 37 | (uint64_t)latch->valid << 53;
+}
+
+/**
+ * Counts the latch bits that changed since the last call, charged to the
+ * instruction the latch holds (or held, if it was emptied).
+ */
+static void countLatchToggles() {
+    uint64_t bits = packIfId(&IF_ID);
+    if (bits != latchBits[0]) {
+        if (IF_ID.valid) latchPc[0] = IF_ID.nextPC - 1;
+        SET_ACTIVITY_PC(latchPc[0]);
+        COUNT_ACTIVITY_N(ACT_LATCH_TOGGLE, SIM_POPCOUNT64(bits ^ latchBits[0]));
+        latchBits[0] = bits;
+    }
+    bits = packIdEx(&ID_EX);
+    if (bits != latchBits[1]) {
+        if (ID_EX.valid) latchPc[1] = ID_EX.nextPC - 1;
+        SET_ACTIVITY_PC(latchPc[1]);
+        COUNT_ACTIVITY_N(ACT_LATCH_TOGGLE, SIM_POPCOUNT64(bits ^ latchBits[1]));
+        latchBits[1] = bits;
+    }
+}
+
+// Takes latches loaded from outside the pipeline as the new toggle baseline
+static void syncLatchBits() {
+    latchBits[0] = packIfId(&IF_ID);
+    latchBits[1] = packIdEx(&ID_EX);
+    latchPc[0] = latchPc[1] = ACTIVITY_NO_PC;
+}
 
 /**
  * Initializes the pipeline registers.
@@ -26,7 +111,13 @@ void initPipeline() {
     ID_EX.valid = false;
 
     cycle = 0;
+    instructionCount = 0;
     isHalted = false;
+    isStalled = false;
+    issueBlocked = false;
+    initScoreboard();
+    initActivity();
+    syncLatchBits();
 }
 
 /**
@@ -34,112 +125,144 @@ void initPipeline() {
  */
 void fetchStage() {
     if (isHalted) return;
+    SET_ACTIVITY_PC(PC);
 
-    if (PC < INSTRUCTION_MEMORY_SIZE) {
-        uint16_t instruction = readFromMemory(PC, 0);
+    // Fetching past the end of instruction memory behaves like fetching HALT,
+    // so a branch out of range stops the program instead of idling forever
+    uint16_t instruction = PC < INSTRUCTION_MEMORY_SIZE ? readFromMemory(PC, 0) : 0xFFFF;
 
-        // Detect HALT Instruction (0xFFFF)
-        if (instruction == 0xFFFF) {
-            printf("[HALT] Halt instruction detected. Pipeline will drain...\n");
-            isHalted = true;
-            IF_ID.valid = false;
-            return;
+    // Detect HALT Instruction (0xFFFF)
+    if (instruction == 0xFFFF) {
+        TRACE("[HALT] Halt instruction detected. Pipeline will drain...\n");
+        isHalted = true;
+        IF_ID.valid = false;
+        if (traceCallbacks.onHalt) {
+            traceCallbacks.onHalt(traceCallbacks.user);
         }
+        return;
+    }
 
-        IF_ID.instruction = instruction;
-        IF_ID.nextPC = PC + 1;
-        IF_ID.valid = true;
-        incrementPC();
+    IF_ID.instruction = instruction;
+    IF_ID.nextPC = PC + 1;
+    IF_ID.valid = true;
+    incrementPC();
 
-        printf("[IF] Fetched Instruction: %d (0x%04X) | Next PC: %d (0x%04X)\n", instruction, (uint16_t)instruction, IF_ID.nextPC, (uint16_t)IF_ID.nextPC);
-    }
+    TRACE("[IF] Fetched Instruction: %d (0x%04X) | Next PC: %d (0x%04X)\n", instruction, (uint16_t)instruction, IF_ID.nextPC, (uint16_t)IF_ID.nextPC);
+}
+
+/**
+ * Splits an instruction word into the opcode, R1 and operand fields of a
+ * decode latch. Table-driven: the 6-bit operand is sign-extended unless the
+ * opcode's operand is a register or an address.
+ */
+void decodeFields(uint16_t instr, ID_EX_Reg* latch) {
+    latch->opcode = (instr >> 12) & 0x0F;
+    latch->r1 = (instr >> 6) & 0x3F;
+
+    DecodeInfo info = DECODE_TABLE[latch->opcode];
+    uint8_t operand = instr & 0x3F;
+    uint8_t signFill = (uint8_t)(0xC0 * !info.zeroExtend) & (uint8_t)-(operand >> 5);
+    latch->r2 = operand | signFill;
+    latch->isImmediate = !info.registerForm;
 }
 
 /**
  * Instruction Decode (ID) Stage
  */
 void decodeStage() {
-    if (!IF_ID.valid) return;
-
-    uint16_t instr = IF_ID.instruction;
-    ID_EX.opcode = (instr >> 12) & 0x0F;
-    ID_EX.r1 = (instr >> 6) & 0x3F;
-
-    // R-Format or I-Format
-    if (ID_EX.opcode == 0 || ID_EX.opcode == 1 || ID_EX.opcode == 2 || 
-        ID_EX.opcode == 6 || ID_EX.opcode == 7) {
-        // R-Format
-        ID_EX.r2 = instr & 0x3F;
-        ID_EX.isImmediate = false;
-    } else {
-        // I-Format
-        uint8_t imm = instr & 0x3F;
-        
-        // Special handling for STR and LDR - addresses should be unsigned
-        if (ID_EX.opcode == 10 || ID_EX.opcode == 11) {  // LDR or STR
-            ID_EX.r2 = imm;  // Keep address as unsigned
+    if (!IF_ID.valid || issueBlocked) return;
+    SET_ACTIVITY_PC(IF_ID.nextPC - 1);
+    COUNT_ACTIVITY(ACT_DECODE);
+
+    decodeFields(IF_ID.instruction, &ID_EX);
+    ID_EX.nextPC = IF_ID.nextPC;
+    ID_EX.resolved = false;
+
+    if (branchInDecode && (ISA_TABLE[ID_EX.opcode].flags & ISA_BRANCH)) {
+        // The comparator reads the register file in ID; a value the
+        // instruction in EX produces this cycle is not there yet
+        bool readsR2 = ISA_TABLE[ID_EX.opcode].flags & ISA_READS_R2;
+        if (lastWrittenRegister == ID_EX.r1 || (readsR2 && lastWrittenRegister == ID_EX.r2) ||
+            isRegisterPending(ID_EX.r1, cycle) || (readsR2 && isRegisterPending(ID_EX.r2, cycle))) {
+            TRACE("[ID] Branch waits for its source registers\n");
+            isStalled = true;
+            return;
+        }
+        ID_EX.resolved = true;
+        if (ID_EX.opcode == OP_BEQZ) {
+            ID_EX.taken = readRegister(ID_EX.r1) == 0;
+            ID_EX.target = IF_ID.nextPC + (int8_t)ID_EX.r2;
         } else {
-            // For other immediates, handle signed values
-            if (imm & 0x20) {  // If bit 5 is set (negative number)
-                ID_EX.r2 = imm | 0xC0;  // Sign extend to 8 bits
-            } else {
-                ID_EX.r2 = imm;  // Positive number, no sign extension needed
-            }
+            ID_EX.taken = true;
+            ID_EX.target = (readRegister(ID_EX.r1) << 8) | readRegister(ID_EX.r2);
+        }
+        if (ID_EX.taken) {
+            redirectFetch(ID_EX.target);
         }
-        ID_EX.isImmediate = true;
     }
-
-    ID_EX.nextPC = IF_ID.nextPC;
     ID_EX.valid = true;
 
     // Print the decoded value appropriately based on instruction type
-    if (ID_EX.opcode == 10 || ID_EX.opcode == 11) {
-        printf("[ID] Decoded - Opcode: %d, R1: %d, Address: %d (0x%02X), Immediate? %d\n",
+    if (ISA_TABLE[ID_EX.opcode].operand == OPERAND_ADDRESS) {
+        TRACE("[ID] Decoded - Opcode: %d, R1: %d, Address: %d (0x%02X), Immediate? %d\n",
                ID_EX.opcode, ID_EX.r1, ID_EX.r2, ID_EX.r2, ID_EX.isImmediate);
     } else {
-        printf("[ID] Decoded - Opcode: %d, R1: %d, R2/IMM: %d (0x%02X), Immediate? %d\n",
+        TRACE("[ID] Decoded - Opcode: %d, R1: %d, R2/IMM: %d (0x%02X), Immediate? %d\n",
                ID_EX.opcode, ID_EX.r1, (int8_t)ID_EX.r2, ID_EX.r2, ID_EX.isImmediate);
     }
 }
 
 void executeStage() {
+    lastWrittenRegister = NO_REGISTER;
     if (!ID_EX.valid) return;
+    SET_ACTIVITY_PC(ID_EX.nextPC - 1);
 
-    printf("[EX] Executing Instruction - Opcode: %d\n", ID_EX.opcode);
+    IssueHazard hazard = checkIssue(ID_EX.opcode, ID_EX.r1, ID_EX.r2, cycle);
+    if (hazard != HAZARD_NONE) {
+        // Hold the instruction in ID/EX; nothing behind it moves either
+        TRACE("[EX] Issue stalled - Opcode: %d (%s hazard)\n", ID_EX.opcode,
+              hazard == HAZARD_RAW ? "RAW" : hazard == HAZARD_WAW ? "WAW" : "structural");
+        recordStall(hazard);
+        issueBlocked = true;
+        isStalled = true;
+        return;
+    }
 
-    if (ID_EX.isImmediate) {
-        // I-Format instructions
-        switch (ID_EX.opcode) {
-            case 3:  execute_MOVI(ID_EX.r1, ID_EX.r2); break;
-            case 4:  if(IF_ID.valid){
-                        setPC(PC-2);
-                     }else{
-                        setPC(PC-1);
-                     }
-                     execute_BEQZ(ID_EX.r1, ID_EX.r2);break;
-            case 5:  execute_ANDI(ID_EX.r1, ID_EX.r2); break;
-            case 8:  execute_SAL(ID_EX.r1, ID_EX.r2); break;
-            case 9:  execute_SAR(ID_EX.r1, ID_EX.r2); break;
-            case 10: execute_LDR(ID_EX.r1, ID_EX.r2); break;
-            case 11: execute_STR(ID_EX.r1, ID_EX.r2); break;
-            default:
-                printf("[EX] Unknown I-Format Opcode: %d\n", ID_EX.opcode);
-                break;
+    TRACE("[EX] Executing Instruction - Opcode: %d\n", ID_EX.opcode);
+    instructionCount++;
+
+    if (ID_EX.resolved) {
+        // Branch resolved in ID: fetch was already redirected
+        TRACE("[EX] Branch resolved in ID - %s\n", ID_EX.taken ? "taken" : "not taken");
+        if (ID_EX.taken && traceCallbacks.onBranch) {
+            traceCallbacks.onBranch(traceCallbacks.user, ID_EX.target);
         }
     } else {
-        // R-Format instructions
         switch (ID_EX.opcode) {
-            case 0: execute_ADD(ID_EX.r1, ID_EX.r2); break;
-            case 1: execute_SUB(ID_EX.r1, ID_EX.r2); break;
-            case 2: execute_MUL(ID_EX.r1, ID_EX.r2); break;
-            case 6: execute_EOR(ID_EX.r1, ID_EX.r2); break;
-            case 7: execute_BR(ID_EX.r1, ID_EX.r2); break;
+            ISA_INSTRUCTIONS(EXECUTE_CASE)
             default:
-                printf("[EX] Unknown R-Format Opcode: %d\n", ID_EX.opcode);
+                TRACE("[EX] Unknown I-Format Opcode: %d\n", ID_EX.opcode);
                 break;
         }
     }
 
+    // A taken branch redirects fetch, even past a HALT that was already fetched
+    if (isStalled) {
+        isHalted = false;
+    }
+
+    if (ISA_TABLE[ID_EX.opcode].flags & ISA_WRITES_R1) {
+        lastWrittenRegister = ID_EX.r1;
+    }
+    recordIssue(ID_EX.opcode, ID_EX.r1, cycle);
+
+    if (traceCallbacks.onRetire) {
+        RetireRecord record;
+        bool taken = ID_EX.resolved ? ID_EX.taken : isStalled;
+        describeRetirement(&record, ID_EX.nextPC - 1, ID_EX.opcode, ID_EX.r1, ID_EX.r2, taken);
+        traceCallbacks.onRetire(traceCallbacks.user, &record);
+    }
+
     ID_EX.valid = false;
 }
 
@@ -148,33 +271,172 @@ void executeStage() {
  * Returns true if the pipeline is still active, false if it's fully drained.
  */
 bool pipelineCycle() {
-    printf("\n=========== Cycle %d ===========\n", ++cycle);
+    PROFILE_BEGIN(cycle);
+    cycle++;
+    TRACE("\n=========== Cycle %llu ===========\n", (unsigned long long)cycle);
+    PROFILE_BEGIN(execute);
     executeStage();
+    PROFILE_END(execute, PROFILE_EXECUTE);
+    PROFILE_BEGIN(decode);
     decodeStage();
+    PROFILE_END(decode, PROFILE_DECODE);
     if(!isStalled){
+        PROFILE_BEGIN(fetch);
         fetchStage();
+        PROFILE_END(fetch, PROFILE_FETCH);
     }
     isStalled = false;
-    printPipelineState();
-    printf("-------------------------------------\n");
+    issueBlocked = false;
+    if (latchToggleCounting) {
+        countLatchToggles();
+    }
+    // Accesses between cycles (presets, loads) are not any instruction's
+    SET_ACTIVITY_PC(ACTIVITY_NO_PC);
+    if (traceActive) {
+        PROFILE_BEGIN(print);
+        printPipelineState();
+        TRACE("-------------------------------------\n");
+        PROFILE_END(print, PROFILE_PRINT_STATE);
+    }
+    PROFILE_END(cycle, PROFILE_CYCLE);
 
     // Check if the pipeline is empty and halted
-    if (isHalted && !IF_ID.valid && !ID_EX.valid) {
+    if (isPipelineDrained()) {
         return false; // Pipeline is drained
     }
     return true; // Continue execution
 }
 
+/**
+ * Returns true once HALT has been fetched, every stage is empty and no
+ * multi-cycle instruction is still in a functional unit.
+ */
+bool isPipelineDrained() {
+    return isHalted && !IF_ID.valid && !ID_EX.valid && areUnitsIdle(cycle);
+}
+
+/**
+ * Enables counting the IF_ID / ID_EX bits that flip each cycle (ACT_LATCH_TOGGLE).
+ */
+void setLatchToggleCounting(bool enabled) {
+    latchToggleCounting = enabled;
+    syncLatchBits();
+}
+
+/**
+ * Selects where BEQZ/BR are resolved: in EX (default, two bubbles per taken
+ * branch) or in ID (one bubble, plus one stall when the instruction ahead
+ * writes a register the branch reads).
+ */
+void setBranchInDecode(bool enabled) {
+    branchInDecode = enabled;
+}
+
+bool isBranchInDecode() {
+    return branchInDecode;
+}
+
+uint64_t getCycleCount() {
+    return cycle;
+}
+
+uint64_t getInstructionCount() {
+    return instructionCount;
+}
+
+/**
+ * Copies the pipeline latches and counters into a snapshot.
+ */
+void savePipeline(PipelineSnapshot* snapshot) {
+    snapshot->ifId = IF_ID;
+    snapshot->idEx = ID_EX;
+    snapshot->cycle = cycle;
+    snapshot->instructionCount = instructionCount;
+    snapshot->halted = isHalted;
+    snapshot->stalled = isStalled;
+    snapshot->scoreboard = scoreboard;
+}
+
+/**
+ * Restores the pipeline latches and counters from a snapshot.
+ */
+void restorePipeline(const PipelineSnapshot* snapshot) {
+    IF_ID = snapshot->ifId;
+    ID_EX = snapshot->idEx;
+    cycle = snapshot->cycle;
+    instructionCount = snapshot->instructionCount;
+    isHalted = snapshot->halted;
+    isStalled = snapshot->stalled;
+    scoreboard = snapshot->scoreboard;
+    syncLatchBits();
+}
+
+/**
+ * Describes the pipeline as the next instruction to execute and its EX cycle.
+ * Latched instructions are discarded: they are refetched from the same PCs.
+ * @return: false if the pipeline has already drained.
+ */
+bool savePipelinePosition(PipelinePosition* position) {
+    if (ID_EX.valid) {
+        position->pc = ID_EX.nextPC - 1;
+        position->nextExecute = cycle + 1;
+        position->streaming = true;
+    } else if (IF_ID.valid) {
+        // Fetched one cycle after an empty pipeline
+        position->pc = IF_ID.nextPC - 1;
+        position->nextExecute = cycle + 2;
+        position->streaming = false;
+    } else if (!isHalted) {
+        position->pc = PC;
+        position->nextExecute = cycle + 3;
+        position->streaming = false;
+    } else {
+        return false;
+    }
+    position->lastWrite = NO_REGISTER;
+    return true;
+}
+
+/**
+ * Rebuilds the latches and counters for a position reached by a functional
+ * engine, as if the pipeline had run there cycle by cycle.
+ * @param position: Next instruction and the cycle it would execute in.
+ * @param executed: Instructions the engine retired since savePipelinePosition.
+ */
+void restorePipelinePosition(const PipelinePosition* position, uint64_t executed) {
+    instructionCount += executed;
+    IF_ID.valid = false;
+    ID_EX.valid = false;
+    isHalted = false;
+    isStalled = false;
+    setPC(position->pc);
+
+    if (position->streaming) {
+        // The previous instruction just executed; its successors are in IF and ID
+        cycle = position->nextExecute - 1;
+        fetchStage();
+        lastWrittenRegister = position->lastWrite;
+        decodeStage();
+        if (!isStalled) {
+            fetchStage();
+        }
+        isStalled = false;
+    } else {
+        cycle = position->nextExecute - 3;
+    }
+    syncLatchBits();
+}
+
 /**
  * Prints the current state of the pipeline.
  */
  void printPipelineState() {
-    printf("==== Pipeline State ====\n");
-    printf("IF/ID -> Instruction: %d (0x%04X) | Next PC: %d (0x%04X) | Valid: %d\n", 
+    TRACE("==== Pipeline State ====\n");
+    TRACE("IF/ID -> Instruction: %d (0x%04X) | Next PC: %d (0x%04X) | Valid: %d\n", 
            IF_ID.instruction, (uint16_t)IF_ID.instruction, IF_ID.nextPC, (uint16_t)IF_ID.nextPC, IF_ID.valid);
-    printf("ID/EX -> Opcode: %d | R1: %d | R2/Imm: %d | Format: %s | Next PC: %d (0x%04X) | Valid: %d\n",
+    TRACE("ID/EX -> Opcode: %d | R1: %d | R2/Imm: %d | Format: %s | Next PC: %d (0x%04X) | Valid: %d\n",
            ID_EX.opcode, ID_EX.r1, ID_EX.r2,
            ID_EX.isImmediate ? "I-Format" : "R-Format",
            ID_EX.nextPC, (uint16_t)ID_EX.nextPC, ID_EX.valid);
-    printf("========================\n\n");
+    TRACE("========================\n\n");
 }
\ No newline at end of file
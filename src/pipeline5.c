@@ -0,0 +1,366 @@
+#include <stdio.h>
+#include "../includes/pipeline5.h"
+#include "../includes/trace.h"
+#include "../includes/retire_trace.h"
+#include "../includes/profile.h"
+#include "../includes/isa.h"
+#include "../includes/activity.h"
+
+// ================== Pipeline Register Definitions ==================
+static SIM_THREAD_LOCAL IF_ID_Reg IF_ID5;
+static SIM_THREAD_LOCAL ID_EX_Reg ID_EX5;
+static SIM_THREAD_LOCAL EX_MEM_Reg EX_MEM;
+static SIM_THREAD_LOCAL MEM_WB_Reg MEM_WB;
+// Instruction in WB this cycle, the source of the MEM/WB forwarding path
+static SIM_THREAD_LOCAL MEM_WB_Reg retiring;
+
+static SIM_THREAD_LOCAL uint64_t cycle = 0;
+static SIM_THREAD_LOCAL uint64_t instructionCount = 0;
+static SIM_THREAD_LOCAL bool isHalted = false;
+// IF holds this cycle (ID stall or a redirect)
+static SIM_THREAD_LOCAL bool holdFetch = false;
+static SIM_THREAD_LOCAL Pipeline5Stats stats;
+
+// Execute handler arguments by operand kind
+#define EXECUTE5_ARGS_REGISTER  ID_EX5.r1, ID_EX5.r2
+#define EXECUTE5_ARGS_IMMEDIATE ID_EX5.r1, ID_EX5.r2
+#define EXECUTE5_ARGS_OFFSET    ID_EX5.r1, ID_EX5.r2, ID_EX5.nextPC
+#define EXECUTE5_ARGS_SHIFT     ID_EX5.r1, ID_EX5.r2
+#define EXECUTE5_ARGS_ADDRESS   ID_EX5.r1, ID_EX5.r2
+
+#define EXECUTE5_CASE(name, opcode, operand, flags, unit) \
+    case opcode: execute_##name(EXECUTE5_ARGS_##operand); break;
+
+// ================== Hazard Helpers ==================
+
+// True if the latched instruction writes reg
+static bool writesRegister(const EX_MEM_Reg* latch, uint8_t reg) {
+    return latch->valid && (ISA_TABLE[latch->opcode].flags & ISA_WRITES_R1) && latch->r1 == reg;
+}
+
+// True if the latched instruction is a load into reg
+static bool loadsRegister(const EX_MEM_Reg* latch, uint8_t reg) {
+    return writesRegister(latch, reg) && (ISA_TABLE[latch->opcode].flags & ISA_LOADS);
+}
+
+// Registers a decoded instruction reads in EX; STR's data is only needed in MEM
+static int sourcesOf(const ID_EX_Reg* latch, uint8_t sources[2]) {
+    uint8_t flags = ISA_TABLE[latch->opcode].flags;
+    int count = 0;
+    if ((flags & ISA_READS_R1) && !(flags & ISA_STORES)) sources[count++] = latch->r1;
+    if (flags & ISA_READS_R2) sources[count++] = latch->r2;
+    return count;
+}
+
+// Branch comparator inputs, read in ID
+static int branchSourcesOf(const ID_EX_Reg* latch, uint8_t sources[2]) {
+    int count = 0;
+    sources[count++] = latch->r1;
+    if (ISA_TABLE[latch->opcode].flags & ISA_READS_R2) sources[count++] = latch->r2;
+    return count;
+}
+
+static void redirect(uint16_t targetPC) {
+    IF_ID5.valid = false;
+    holdFetch = true;
+    isHalted = false;
+    setPC(targetPC);
+    stats.takenBranches++;
+}
+
+/**
+ * Initializes the latches and counters.
+ */
+void initPipeline5() {
+    IF_ID5 = (IF_ID_Reg){0};
+    ID_EX5 = (ID_EX_Reg){0};
+    EX_MEM = (EX_MEM_Reg){0};
+    MEM_WB = (MEM_WB_Reg){0};
+    retiring = (MEM_WB_Reg){0};
+    cycle = 0;
+    instructionCount = 0;
+    isHalted = false;
+    holdFetch = false;
+    stats = (Pipeline5Stats){0};
+}
+
+// ================== Stages ==================
+
+/**
+ * Write Back (WB) Stage: retires the instruction.
+ */
+static void writeBackStage() {
+    retiring = MEM_WB;
+    MEM_WB.valid = false;
+    if (!retiring.valid) return;
+
+    instructionCount++;
+    TRACE("[WB] Retired - Opcode: %d | PC: %d\n", retiring.opcode, retiring.nextPC - 1);
+    if (traceCallbacks.onRetire) {
+        RetireRecord record;
+        describeRetirement(&record, retiring.nextPC - 1, retiring.opcode, retiring.r1, retiring.r2,
+                           retiring.taken);
+        traceCallbacks.onRetire(traceCallbacks.user, &record);
+    }
+}
+
+/**
+ * Memory Access (MEM) Stage
+ */
+static void memoryStage() {
+    if (!EX_MEM.valid) return;
+    MEM_WB = EX_MEM;
+    EX_MEM.valid = false;
+
+    SET_ACTIVITY_PC(MEM_WB.nextPC - 1);
+    if (MEM_WB.opcode == OP_LDR) {
+        execute_LDR(MEM_WB.r1, MEM_WB.r2);
+    } else if (MEM_WB.opcode == OP_STR) {
+        execute_STR(MEM_WB.r1, MEM_WB.r2);
+    }
+}
+
+/**
+ * Execute (EX) Stage: ALU operations and branch resolution.
+ */
+static void executeStage5() {
+    if (!ID_EX5.valid) return;
+    ID_EX5.valid = false;
+    SET_ACTIVITY_PC(ID_EX5.nextPC - 1);
+    TRACE("[EX] Executing Instruction - Opcode: %d\n", ID_EX5.opcode);
+
+    uint8_t flags = ISA_TABLE[ID_EX5.opcode].flags;
+    bool taken = false;
+    if (ID_EX5.resolved) {
+        // Branch resolved in ID: fetch was already redirected
+        taken = ID_EX5.taken;
+        if (taken && traceCallbacks.onBranch) {
+            traceCallbacks.onBranch(traceCallbacks.user, ID_EX5.target);
+        }
+    } else {
+        // Operands produced by the two instructions ahead come off the bypass
+        uint8_t sources[2];
+        int count = sourcesOf(&ID_EX5, sources);
+        for (int i = 0; i < count; i++) {
+            if (writesRegister(&MEM_WB, sources[i])) {
+                stats.forwardsExMem++;
+            } else if (writesRegister(&retiring, sources[i])) {
+                stats.forwardsMemWb++;
+            }
+        }
+
+        if (flags & ISA_BRANCH) {
+            uint16_t target;
+            if (ID_EX5.opcode == OP_BEQZ) {
+                taken = readRegister(ID_EX5.r1) == 0;
+                target = ID_EX5.nextPC + (int8_t)ID_EX5.r2;
+            } else {
+                taken = true;
+                target = (readRegister(ID_EX5.r1) << 8) | readRegister(ID_EX5.r2);
+            }
+            if (taken) {
+                TRACE("[EX] Branch taken -> %d (0x%04X), IF and ID flushed\n", target, target);
+                redirect(target);
+                if (traceCallbacks.onBranch) {
+                    traceCallbacks.onBranch(traceCallbacks.user, target);
+                }
+            }
+        } else if (!(flags & (ISA_LOADS | ISA_STORES))) {
+            // Branches and memory operations never reach the switch
+            switch (ID_EX5.opcode) {
+                ISA_INSTRUCTIONS(EXECUTE5_CASE)
+                default:
+                    TRACE("[EX] Unknown I-Format Opcode: %d\n", ID_EX5.opcode);
+                    break;
+            }
+        }
+    }
+
+    EX_MEM.opcode = ID_EX5.opcode;
+    EX_MEM.r1 = ID_EX5.r1;
+    EX_MEM.r2 = ID_EX5.r2;
+    EX_MEM.nextPC = ID_EX5.nextPC;
+    EX_MEM.taken = taken;
+    EX_MEM.valid = true;
+}
+
+/**
+ * Instruction Decode (ID) Stage: hazard detection, and branch resolution
+ * when branches resolve in ID.
+ */
+static void decodeStage5() {
+    if (!IF_ID5.valid) return;
+    SET_ACTIVITY_PC(IF_ID5.nextPC - 1);
+    COUNT_ACTIVITY(ACT_DECODE);
+
+    ID_EX_Reg decoded;
+    decodeFields(IF_ID5.instruction, &decoded);
+    decoded.nextPC = IF_ID5.nextPC;
+    decoded.resolved = false;
+    decoded.taken = false;
+    decoded.target = 0;
+
+    uint8_t sources[2];
+    bool inDecode = isBranchInDecode() && (ISA_TABLE[decoded.opcode].flags & ISA_BRANCH);
+    if (inDecode) {
+        // The comparator needs an ALU result one cycle after EX and a loaded value one after MEM
+        int count = branchSourcesOf(&decoded, sources);
+        for (int i = 0; i < count; i++) {
+            if (writesRegister(&EX_MEM, sources[i]) || loadsRegister(&MEM_WB, sources[i])) {
+                TRACE("[ID] Branch waits for its source registers\n");
+                stats.branchStalls++;
+                holdFetch = true;
+                return;
+            }
+        }
+    } else {
+        // A loaded value reaches EX through the MEM/WB bypass at the earliest
+        int count = sourcesOf(&decoded, sources);
+        for (int i = 0; i < count; i++) {
+            if (loadsRegister(&EX_MEM, sources[i])) {
+                TRACE("[ID] Load-use stall on R%d\n", sources[i]);
+                stats.loadUseStalls++;
+                holdFetch = true;
+                return;
+            }
+        }
+    }
+
+    if (inDecode) {
+        decoded.resolved = true;
+        if (decoded.opcode == OP_BEQZ) {
+            decoded.taken = readRegister(decoded.r1) == 0;
+            decoded.target = decoded.nextPC + (int8_t)decoded.r2;
+        } else {
+            decoded.taken = true;
+            decoded.target = (readRegister(decoded.r1) << 8) | readRegister(decoded.r2);
+        }
+    }
+
+    ID_EX5 = decoded;
+    ID_EX5.valid = true;
+    IF_ID5.valid = false;
+    if (decoded.resolved && decoded.taken) {
+        TRACE("[ID] Branch resolved in ID -> %d (0x%04X)\n", decoded.target, decoded.target);
+        redirect(decoded.target);
+    }
+    TRACE("[ID] Decoded - Opcode: %d, R1: %d, R2/IMM: %d (0x%02X), Immediate? %d\n",
+          ID_EX5.opcode, ID_EX5.r1, (int8_t)ID_EX5.r2, ID_EX5.r2, ID_EX5.isImmediate);
+}
+
+/**
+ * Instruction Fetch (IF) Stage
+ */
+static void fetchStage5() {
+    if (isHalted || holdFetch) return;
+    SET_ACTIVITY_PC(PC);
+
+    // Fetching past the end of instruction memory behaves like fetching HALT
+    uint16_t instruction = PC < INSTRUCTION_MEMORY_SIZE ? readFromMemory(PC, 0) : 0xFFFF;
+    if (instruction == 0xFFFF) {
+        TRACE("[HALT] Halt instruction detected. Pipeline will drain...\n");
+        isHalted = true;
+        if (traceCallbacks.onHalt) {
+            traceCallbacks.onHalt(traceCallbacks.user);
+        }
+        return;
+    }
+
+    IF_ID5.instruction = instruction;
+    IF_ID5.nextPC = PC + 1;
+    IF_ID5.valid = true;
+    incrementPC();
+    TRACE("[IF] Fetched Instruction: %d (0x%04X) | Next PC: %d (0x%04X)\n", instruction,
+          (uint16_t)instruction, IF_ID5.nextPC, (uint16_t)IF_ID5.nextPC);
+}
+
+static void printPipeline5State() {
+    TRACE("==== Pipeline State ====\n");
+    TRACE("IF/ID  -> Instruction: 0x%04X | Next PC: %d | Valid: %d\n",
+          IF_ID5.instruction, IF_ID5.nextPC, IF_ID5.valid);
+    TRACE("ID/EX  -> Opcode: %d | R1: %d | R2/Imm: %d | Next PC: %d | Valid: %d\n",
+          ID_EX5.opcode, ID_EX5.r1, ID_EX5.r2, ID_EX5.nextPC, ID_EX5.valid);
+    TRACE("EX/MEM -> Opcode: %d | R1: %d | R2/Addr: %d | Next PC: %d | Valid: %d\n",
+          EX_MEM.opcode, EX_MEM.r1, EX_MEM.r2, EX_MEM.nextPC, EX_MEM.valid);
+    TRACE("MEM/WB -> Opcode: %d | R1: %d | R2/Addr: %d | Next PC: %d | Valid: %d\n",
+          MEM_WB.opcode, MEM_WB.r1, MEM_WB.r2, MEM_WB.nextPC, MEM_WB.valid);
+    TRACE("========================\n\n");
+}
+
+// ================== Public Interface ==================
+
+/**
+ * Advances the five-stage pipeline by one cycle. Stages run from WB back to
+ * IF, so each one consumes its input latch before the stage behind refills it.
+ * @return: true while the pipeline is still active, false once drained.
+ */
+bool pipeline5Cycle() {
+    PROFILE_BEGIN(cycle);
+    cycle++;
+    TRACE("\n=========== Cycle %llu ===========\n", (unsigned long long)cycle);
+    writeBackStage();
+    memoryStage();
+    executeStage5();
+    decodeStage5();
+    fetchStage5();
+    holdFetch = false;
+    SET_ACTIVITY_PC(ACTIVITY_NO_PC);
+    if (traceActive) {
+        printPipeline5State();
+    }
+    PROFILE_END(cycle, PROFILE_CYCLE);
+    return !isPipeline5Drained();
+}
+
+/**
+ * Returns true once HALT has been fetched and every stage is empty.
+ */
+bool isPipeline5Drained() {
+    return isHalted && !IF_ID5.valid && !ID_EX5.valid && !EX_MEM.valid && !MEM_WB.valid;
+}
+
+uint64_t getPipeline5Cycles() {
+    return cycle;
+}
+
+uint64_t getPipeline5Instructions() {
+    return instructionCount;
+}
+
+const Pipeline5Stats* getPipeline5Stats() {
+    return &stats;
+}
+
+/**
+ * Reports the instruction that enters EX next cycle, for breakpoints.
+ * @return: false if ID/EX is empty.
+ */
+bool peekPipeline5Execute(uint16_t* pc) {
+    if (!ID_EX5.valid) return false;
+    *pc = ID_EX5.nextPC - 1;
+    return true;
+}
+
+void savePipeline5(Pipeline5Snapshot* snapshot) {
+    snapshot->ifId = IF_ID5;
+    snapshot->idEx = ID_EX5;
+    snapshot->exMem = EX_MEM;
+    snapshot->memWb = MEM_WB;
+    snapshot->cycle = cycle;
+    snapshot->instructionCount = instructionCount;
+    snapshot->halted = isHalted;
+    snapshot->stats = stats;
+}
+
+void restorePipeline5(const Pipeline5Snapshot* snapshot) {
+    IF_ID5 = snapshot->ifId;
+    ID_EX5 = snapshot->idEx;
+    EX_MEM = snapshot->exMem;
+    MEM_WB = snapshot->memWb;
+    cycle = snapshot->cycle;
+    instructionCount = snapshot->instructionCount;
+    isHalted = snapshot->halted;
+    stats = snapshot->stats;
+    retiring.valid = false;
+    holdFetch = false;
+}
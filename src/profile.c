@@ -0,0 +1,194 @@
+#include "../includes/profile.h"
+
+#ifdef SIM_PROFILE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include "../includes/platform.h"
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define PROFILE_TSC 1
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define PROFILE_TSC 1
+#endif
+
+// ================== Histograms ==================
+// Log-linear buckets: exact below 16 ticks, then 16 sub-buckets per power
+// of two, so any percentile is within ~6% of the true value.
+
+#define SUB_BUCKET_BITS 4
+#define SUB_BUCKETS (1 << SUB_BUCKET_BITS)
+#define BUCKET_COUNT (SUB_BUCKETS + (64 - SUB_BUCKET_BITS) * SUB_BUCKETS)
+
+typedef struct {
+    uint64_t count;
+    uint64_t totalTicks;
+    uint64_t maxTicks;
+    uint64_t buckets[BUCKET_COUNT];
+} PhaseHistogram;
+
+static const char* PHASE_NAMES[PROFILE_PHASE_COUNT] = {
+    "cycle", "  execute", "  decode", "  fetch", "  print state", "block run", "program load", "state dump"
+};
+
+// This thread's samples since its last flush
+static SIM_THREAD_LOCAL PhaseHistogram histograms[PROFILE_PHASE_COUNT];
+static SIM_THREAD_LOCAL bool pending = false;
+
+// Process-wide totals and the calibration start, guarded by mergeLock
+static PhaseHistogram merged[PROFILE_PHASE_COUNT];
+static pthread_mutex_t mergeLock = PTHREAD_MUTEX_INITIALIZER;
+static bool started = false;
+static uint64_t startTicks;
+static double startNs;
+
+static double wallNs() {
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+static unsigned highestBit(uint64_t value) {
+    unsigned bit = 0;
+    while (value >>= 1) bit++;
+    return bit;
+}
+
+static unsigned bucketOf(uint64_t ticks) {
+    if (ticks < SUB_BUCKETS) return (unsigned)ticks;
+    unsigned shift = highestBit(ticks) - SUB_BUCKET_BITS;
+    return SUB_BUCKETS + shift * SUB_BUCKETS + (unsigned)((ticks >> shift) & (SUB_BUCKETS - 1));
+}
+
+// Midpoint of a bucket, in ticks
+static double bucketValue(unsigned bucket) {
+    if (bucket < SUB_BUCKETS) return bucket;
+    unsigned shift = (bucket - SUB_BUCKETS) / SUB_BUCKETS;
+    uint64_t low = (uint64_t)(SUB_BUCKETS + (bucket - SUB_BUCKETS) % SUB_BUCKETS) << shift;
+    return (double)low + ((double)((uint64_t)1 << shift) - 1) / 2;
+}
+
+static double percentile(const PhaseHistogram* h, double fraction) {
+    uint64_t rank = (uint64_t)(fraction * (double)(h->count - 1));
+    uint64_t seen = 0;
+    for (unsigned b = 0; b < BUCKET_COUNT; b++) {
+        seen += h->buckets[b];
+        if (seen > rank) {
+            double value = bucketValue(b);
+            return value < (double)h->maxTicks ? value : (double)h->maxTicks;
+        }
+    }
+    return (double)h->maxTicks;
+}
+
+// ================== Public Interface ==================
+
+/**
+ * Current timestamp in ticks: the TSC on x86, nanoseconds elsewhere.
+ */
+uint64_t profileNow() {
+#ifdef PROFILE_TSC
+    return __rdtsc();
+#else
+    return (uint64_t)wallNs();
+#endif
+}
+
+/**
+ * Adds the time since start to a phase's histogram. The first sample in the
+ * process starts the tick calibration and registers the exit report.
+ */
+void profileRecord(ProfilePhase phase, uint64_t start) {
+    uint64_t ticks = profileNow() - start;
+    if (!pending) {
+        pending = true;
+        pthread_mutex_lock(&mergeLock);
+        if (!started) {
+            started = true;
+            startTicks = start;
+            startNs = wallNs();
+            atexit(printProfileReport);
+        }
+        pthread_mutex_unlock(&mergeLock);
+    }
+    PhaseHistogram* h = &histograms[phase];
+    h->count++;
+    h->totalTicks += ticks;
+    if (ticks > h->maxTicks) h->maxTicks = ticks;
+    h->buckets[bucketOf(ticks)]++;
+}
+
+/**
+ * Moves the calling thread's samples into the process-wide table. Threads
+ * call it before they exit (simDestroy does), as their tables die with them.
+ */
+void profileFlushThread() {
+    if (!pending) return;
+    pthread_mutex_lock(&mergeLock);
+    for (int p = 0; p < PROFILE_PHASE_COUNT; p++) {
+        const PhaseHistogram* h = &histograms[p];
+        PhaseHistogram* total = &merged[p];
+        if (h->count == 0) continue;
+        total->count += h->count;
+        total->totalTicks += h->totalTicks;
+        if (h->maxTicks > total->maxTicks) total->maxTicks = h->maxTicks;
+        for (unsigned b = 0; b < BUCKET_COUNT; b++) {
+            total->buckets[b] += h->buckets[b];
+        }
+    }
+    pthread_mutex_unlock(&mergeLock);
+    memset(histograms, 0, sizeof(histograms));
+    pending = false;
+}
+
+/**
+ * Prints the per-phase histogram summary of every flushed thread, and of
+ * the calling one, to stderr.
+ */
+void printProfileReport() {
+    profileFlushThread();
+    pthread_mutex_lock(&mergeLock);
+    if (!started) {
+        pthread_mutex_unlock(&mergeLock);
+        return;
+    }
+
+    // Ticks per ns over the whole run
+    double elapsedNs = wallNs() - startNs;
+    double ticksPerNs = elapsedNs > 0 ? (double)(profileNow() - startTicks) / elapsedNs : 1.0;
+#ifndef PROFILE_TSC
+    ticksPerNs = 1.0;
+#endif
+
+    // Cost of one empty begin/end pair, for reading the small numbers
+    uint64_t overhead = profileNow();
+    overhead = profileNow() - overhead;
+
+    fprintf(stderr, "\n===== Host Profile (%s, %.2f ticks/ns, timer ~%.0f ns) =====\n",
+#ifdef PROFILE_TSC
+            "TSC",
+#else
+            "timespec_get",
+#endif
+            ticksPerNs, overhead / ticksPerNs);
+    fprintf(stderr, "%-14s %12s %12s %10s %10s %10s %12s\n",
+            "phase", "calls", "total ms", "mean ns", "p50 ns", "p99 ns", "max ns");
+    for (int p = 0; p < PROFILE_PHASE_COUNT; p++) {
+        const PhaseHistogram* h = &merged[p];
+        if (h->count == 0) continue;
+        fprintf(stderr, "%-14s %12llu %12.3f %10.1f %10.1f %10.1f %12.1f\n", PHASE_NAMES[p],
+                (unsigned long long)h->count, h->totalTicks / ticksPerNs / 1e6,
+                (double)h->totalTicks / h->count / ticksPerNs,
+                percentile(h, 0.50) / ticksPerNs, percentile(h, 0.99) / ticksPerNs,
+                h->maxTicks / ticksPerNs);
+    }
+    pthread_mutex_unlock(&mergeLock);
+}
+
+#endif // SIM_PROFILE
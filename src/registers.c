@@ -1,11 +1,13 @@
 #include <stdio.h>
 #include <string.h>
 #include "../includes/registers.h"
+#include "../includes/trace.h"
+#include "../includes/activity.h"
 
 // Register Definitions
-int8_t registers[REGISTER_COUNT];   // General Purpose Registers (signed)
-uint8_t SREG = 0x00;                 // Status Register, initialized to 0
-uint16_t PC = 0x0000;                // Program Counter, initialized to 0
+SIM_THREAD_LOCAL int8_t registers[REGISTER_COUNT];// General Purpose Registers (signed)
+SIM_THREAD_LOCAL uint8_t SREG = 0x00;// Status Register, initialized to 0
+SIM_THREAD_LOCAL uint16_t PC = 0x0000;// Program Counter, initialized to 0
 
 /**
  * Initializes all registers and the program counter to 0.
@@ -23,10 +25,14 @@ void initRegisters() {
  */
 void writeRegister(uint8_t regNum, int8_t value) {
     if (regNum < REGISTER_COUNT) {
+        COUNT_ACTIVITY(ACT_REG_WRITE);
         registers[regNum] = value;
-        printf("[REG] R%d = %d (0x%02X)\n", regNum, value, (uint8_t)value);
+        TRACE("[REG] R%d = %d (0x%02X)\n", regNum, value, (uint8_t)value);
+        if (traceCallbacks.onRegisterWrite) {
+            traceCallbacks.onRegisterWrite(traceCallbacks.user, regNum, value);
+        }
     } else {
-        printf("Error: Register number %d out of bounds\n", regNum);
+        TRACE("Error: Register number %d out of bounds\n", regNum);
     }
 }
 
@@ -37,9 +43,10 @@ void writeRegister(uint8_t regNum, int8_t value) {
  */
 int8_t readRegister(uint8_t regNum) {
     if (regNum < REGISTER_COUNT) {
+        COUNT_ACTIVITY(ACT_REG_READ);
         return registers[regNum];
     } else {
-        printf("Error: Register number %d out of bounds\n", regNum);
+        TRACE("Error: Register number %d out of bounds\n", regNum);
         return 0;
     }
 }
@@ -59,7 +66,7 @@ void clearAllFlags() {
 void setFlag(uint8_t flag) {
     if (flag <= CARRY_FLAG) {  // Only allow flags 0-4
         SREG |= (1 << flag);
-        printf("Setting flag %d (0x%02X)\n", flag, (uint8_t)flag);
+        TRACE("Setting flag %d (0x%02X)\n", flag, (uint8_t)flag);
     }
 }
 
@@ -70,7 +77,7 @@ void setFlag(uint8_t flag) {
 void clearFlag(uint8_t flag) {
     if (flag <= CARRY_FLAG) {  // Only allow flags 0-4
         SREG &= ~(1 << flag);
-        printf("Clearing flag %d (0x%02X)\n", flag, (uint8_t)flag);
+        TRACE("Clearing flag %d (0x%02X)\n", flag, (uint8_t)flag);
     }
 }
 
@@ -90,7 +97,7 @@ uint8_t getFlag(uint8_t flag) {
  * Increments the Program Counter by 1.
  */
 void incrementPC() {
-    printf("Incrementing PC to %d (0x%04X)\n", PC + 1, (uint16_t)(PC + 1));
+    TRACE("Incrementing PC to %d (0x%04X)\n", PC + 1, (uint16_t)(PC + 1));
     PC++;
 }
 
@@ -99,7 +106,7 @@ void incrementPC() {
  * @param address: The address to set the PC to.
  */
 void setPC(uint16_t address) {
-    printf("Setting PC to %d (0x%04X)\n", address, (uint16_t)address);
+    TRACE("Setting PC to %d (0x%04X)\n", address, (uint16_t)address);
     PC = address;
 }
 
@@ -0,0 +1,236 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include "../includes/result_cache.h"
+
+#define ENTRY_MAGIC   0x43524D53u   // "SMRC"
+#define ENTRY_VERSION 1
+#define LOCK_FILE     ".lock"       // Holds the store's byte count; flock()ed for updates
+#define PATH_LENGTH   512
+#define NAME_LENGTH   32            // Longest file name inside the directory
+
+struct ResultCache {
+    char directory[PATH_LENGTH - NAME_LENGTH];
+    uint64_t maxBytes;              // 0 for unlimited
+};
+
+typedef struct {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t resultSize;            // sizeof(CachedResult) of the writer
+    uint64_t check;
+} EntryHeader;
+
+typedef struct {
+    EntryHeader header;
+    CachedResult result;
+} Entry;
+
+// ================== Run Keys ==================
+
+void beginRunKey(RunKeyBuilder* builder) {
+    builder->hash = 0xCBF29CE484222325ull;     // FNV-1a offset basis
+    builder->check = 0x6A09E667F3BCC908ull;
+}
+
+/**
+ * Feeds key material into both hashes: FNV-1a for the file name and a
+ * rotate-multiply hash that an entry must also match.
+ */
+void addToRunKey(RunKeyBuilder* builder, const void* data, size_t length) {
+    const uint8_t* bytes = data;
+    uint64_t hash = builder->hash;
+    uint64_t check = builder->check;
+    for (size_t i = 0; i < length; i++) {
+        hash = (hash ^ bytes[i]) * 0x100000001B3ull;
+        check = check ^ bytes[i];
+        check = ((check << 5) | (check >> 59)) * 0x9E3779B97F4A7C15ull;
+    }
+    builder->hash = hash;
+    builder->check = check;
+}
+
+void finishRunKey(const RunKeyBuilder* builder, RunKey* key) {
+    key->hash = builder->hash;
+    key->check = builder->check;
+}
+
+// ================== Store ==================
+
+static void entryPath(const ResultCache* cache, const RunKey* key, char* path) {
+    snprintf(path, PATH_LENGTH, "%s/%016llx.res", cache->directory, (unsigned long long)key->hash);
+}
+
+/**
+ * Opens (creating if needed) a result store directory.
+ * @param maxBytes: Size limit of the stored entries, 0 for unlimited.
+ * @return: The store, or NULL if the directory cannot be used.
+ */
+ResultCache* openResultCache(const char* directory, uint64_t maxBytes) {
+    if (strlen(directory) >= PATH_LENGTH - NAME_LENGTH) return NULL;
+    if (mkdir(directory, 0755) != 0 && errno != EEXIST) return NULL;
+
+    ResultCache* cache = calloc(1, sizeof(ResultCache));
+    if (!cache) return NULL;
+    snprintf(cache->directory, sizeof(cache->directory), "%s", directory);
+    cache->maxBytes = maxBytes;
+
+    char path[PATH_LENGTH];
+    snprintf(path, sizeof(path), "%s/" LOCK_FILE, cache->directory);
+    int fd = open(path, O_RDWR | O_CREAT, 0644);
+    if (fd < 0) {
+        free(cache);
+        return NULL;
+    }
+    close(fd);
+    return cache;
+}
+
+void closeResultCache(ResultCache* cache) {
+    free(cache);
+}
+
+/**
+ * Reads the entry for a key.
+ * @return: true on a hit; false if there is no entry or it is damaged or
+ *          belongs to a different run with the same file name.
+ */
+bool lookupResult(ResultCache* cache, const RunKey* key, CachedResult* result) {
+    char path[PATH_LENGTH];
+    entryPath(cache, key, path);
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return false;
+
+    Entry entry;
+    bool hit = read(fd, &entry, sizeof(entry)) == (ssize_t)sizeof(entry) &&
+               entry.header.magic == ENTRY_MAGIC && entry.header.version == ENTRY_VERSION &&
+               entry.header.resultSize == sizeof(CachedResult) && entry.header.check == key->check;
+    if (hit) {
+        *result = entry.result;
+        // Recently used entries are evicted last
+        futimens(fd, NULL);
+    }
+    close(fd);
+    return hit;
+}
+
+typedef struct {
+    struct timespec used;
+    off_t size;
+    char name[NAME_LENGTH];
+} StoredFile;
+
+static int compareUse(const void* a, const void* b) {
+    const struct timespec* x = &((const StoredFile*)a)->used;
+    const struct timespec* y = &((const StoredFile*)b)->used;
+    if (x->tv_sec != y->tv_sec) return x->tv_sec < y->tv_sec ? -1 : 1;
+    if (x->tv_nsec != y->tv_nsec) return x->tv_nsec < y->tv_nsec ? -1 : 1;
+    return 0;
+}
+
+/**
+ * Removes the least recently used entries until the store is under 90% of
+ * its limit. Called with the lock held.
+ * @return: Bytes left in the store.
+ */
+static uint64_t evictEntries(const ResultCache* cache) {
+    DIR* dir = opendir(cache->directory);
+    if (!dir) return 0;
+
+    StoredFile* files = NULL;
+    size_t count = 0, capacity = 0;
+    uint64_t total = 0;
+    struct dirent* item;
+    while ((item = readdir(dir)) != NULL) {
+        size_t length = strlen(item->d_name);
+        if (length < 4 || length >= sizeof(files->name) || strcmp(item->d_name + length - 4, ".res") != 0) {
+            continue;
+        }
+        struct stat info;
+        if (fstatat(dirfd(dir), item->d_name, &info, 0) != 0) continue;
+        if (count == capacity) {
+            capacity = capacity ? capacity * 2 : 256;
+            StoredFile* grown = realloc(files, capacity * sizeof(StoredFile));
+            if (!grown) break;
+            files = grown;
+        }
+        files[count].used = info.st_mtim;
+        files[count].size = info.st_size;
+        memcpy(files[count].name, item->d_name, length + 1);
+        total += (uint64_t)info.st_size;
+        count++;
+    }
+
+    qsort(files, count, sizeof(StoredFile), compareUse);
+    uint64_t target = cache->maxBytes - cache->maxBytes / 10;
+    for (size_t i = 0; i < count && total > target; i++) {
+        if (unlinkat(dirfd(dir), files[i].name, 0) == 0) {
+            total -= (uint64_t)files[i].size;
+        }
+    }
+    free(files);
+    closedir(dir);
+    return total;
+}
+
+/**
+ * Adds a run's result to the store, replacing any entry with the same key,
+ * and evicts old entries if the store is over its limit.
+ * @return: 0 on success, -1 if the entry could not be written.
+ */
+int storeResult(ResultCache* cache, const RunKey* key, const CachedResult* result) {
+    Entry entry;
+    memset(&entry, 0, sizeof(entry));
+    entry.header.magic = ENTRY_MAGIC;
+    entry.header.version = ENTRY_VERSION;
+    entry.header.resultSize = sizeof(CachedResult);
+    entry.header.check = key->check;
+    entry.result = *result;
+
+    char temporary[PATH_LENGTH];
+    snprintf(temporary, sizeof(temporary), "%s/.tmp-XXXXXX", cache->directory);
+    int fd = mkstemp(temporary);
+    if (fd < 0) return -1;
+    // mkstemp() creates the file private to its owner; the store is shared
+    fchmod(fd, 0644);
+    bool written = write(fd, &entry, sizeof(entry)) == (ssize_t)sizeof(entry);
+    if (close(fd) != 0 || !written) {
+        unlink(temporary);
+        return -1;
+    }
+
+    char path[PATH_LENGTH];
+    snprintf(path, sizeof(path), "%s/" LOCK_FILE, cache->directory);
+    int lock = open(path, O_RDWR | O_CREAT, 0644);
+    if (lock < 0 || flock(lock, LOCK_EX) != 0) {
+        if (lock >= 0) close(lock);
+        unlink(temporary);
+        return -1;
+    }
+
+    // Readers see the old entry or the new one, never a partial file
+    entryPath(cache, key, path);
+    int status = rename(temporary, path) == 0 ? 0 : -1;
+    if (status != 0) {
+        unlink(temporary);
+    } else {
+        // The byte count is approximate (replaced entries count twice) and
+        // is corrected whenever eviction rescans the directory
+        uint64_t usage = 0;
+        if (pread(lock, &usage, sizeof(usage), 0) != (ssize_t)sizeof(usage)) usage = 0;
+        usage += sizeof(entry);
+        if (cache->maxBytes && usage > cache->maxBytes) {
+            usage = evictEntries(cache);
+        }
+        if (pwrite(lock, &usage, sizeof(usage), 0) != (ssize_t)sizeof(usage)) status = -1;
+    }
+    flock(lock, LOCK_UN);
+    close(lock);
+    return status;
+}
@@ -0,0 +1,66 @@
+#include <string.h>
+#include "../includes/retire_trace.h"
+#include "../includes/isa.h"
+
+#define WRITE_BUFFER_SIZE (1 << 20)
+
+/**
+ * Fills in a retirement record from an instruction leaving EX.
+ * @param pc: Address of the instruction.
+ * @param opcode: Decoded opcode.
+ * @param r1: First operand field (always a register).
+ * @param r2: Second register, immediate or data address.
+ * @param taken: true if the instruction redirected fetch.
+ */
+void describeRetirement(RetireRecord* record, uint16_t pc, uint8_t opcode, uint8_t r1, uint8_t r2, bool taken) {
+    record->pc = pc;
+    record->opcode = opcode;
+    record->flags = taken ? RETIRE_TAKEN : 0;
+    uint8_t flags = ISA_TABLE[opcode & 0x0F].flags;
+    record->dest = flags & ISA_WRITES_R1 ? r1 : RETIRE_NO_REG;
+    record->src1 = flags & ISA_READS_R1 ? r1 : RETIRE_NO_REG;
+    record->src2 = flags & ISA_READS_R2 ? r2 : RETIRE_NO_REG;
+    record->address = flags & (ISA_LOADS | ISA_STORES) ? r2 : 0;
+    if (flags & ISA_WRITES_SREG) record->flags |= RETIRE_WRITES_SREG;
+    if (flags & ISA_LOADS) record->flags |= RETIRE_MEM_READ;
+    if (flags & ISA_STORES) record->flags |= RETIRE_MEM_WRITE;
+}
+
+/**
+ * Creates a trace file and writes a provisional header.
+ * @return: 0 on success, -1 if the file cannot be created.
+ */
+int openRetireTrace(RetireTraceWriter* writer, const char* path) {
+    memset(writer, 0, sizeof(*writer));
+    writer->file = fopen(path, "wb");
+    if (!writer->file) return -1;
+    setvbuf(writer->file, NULL, _IOFBF, WRITE_BUFFER_SIZE);
+
+    writer->header.magic = RETIRE_TRACE_MAGIC;
+    writer->header.version = RETIRE_TRACE_VERSION;
+    writer->header.recordSize = sizeof(RetireRecord);
+    fwrite(&writer->header, sizeof(writer->header), 1, writer->file);
+    return 0;
+}
+
+/**
+ * onRetire callback: appends one record. user is the RetireTraceWriter.
+ */
+void recordRetirement(void* user, const RetireRecord* record) {
+    RetireTraceWriter* writer = user;
+    fwrite(record, sizeof(*record), 1, writer->file);
+    writer->header.recordCount++;
+}
+
+/**
+ * Finalizes the header with the record count and the run's cycle count.
+ * @return: 0 on success, -1 on a write error.
+ */
+int closeRetireTrace(RetireTraceWriter* writer, uint64_t cycles) {
+    writer->header.recordedCycles = cycles;
+    int failed = fseek(writer->file, 0, SEEK_SET) != 0 ||
+                 fwrite(&writer->header, sizeof(writer->header), 1, writer->file) != 1;
+    failed = fclose(writer->file) != 0 || failed;
+    writer->file = NULL;
+    return failed ? -1 : 0;
+}
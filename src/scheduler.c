@@ -0,0 +1,339 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../includes/scheduler.h"
+#include "../includes/scoreboard.h"
+#include "../includes/trace.h"
+
+// ================== Dependency Graph ==================
+
+#define SCHEDULE_WINDOW 64    // Longer blocks are scheduled in windows of this size
+#define NO_REG 0xFF
+
+typedef struct {
+    uint16_t word;
+    uint8_t reads[2];         // Source registers (NO_REG if unused)
+    uint8_t writes;           // Destination register (NO_REG if none)
+    uint8_t latency;          // Cycles until the result can be used
+    bool writesSreg;
+    bool accessesMemory;
+    bool isBranch;
+} SchedNode;
+
+static bool isBranchOpcode(uint8_t opcode) {
+    return ISA_TABLE[opcode & 0x0F].flags & ISA_BRANCH;
+}
+
+// HALT and reserved opcodes do nothing the pass can reason about; they stay put
+static bool isBarrier(uint16_t word) {
+    return word == 0xFFFF || !ISA_TABLE[(word >> 12) & 0x0F].name;
+}
+
+static SchedNode describeNode(uint16_t word, const ScheduleModel* model) {
+    uint8_t opcode = (word >> 12) & 0x0F;
+    uint8_t r1 = (word >> 6) & 0x3F;
+    uint8_t r2 = word & 0x3F;
+    SchedNode node = {word, {NO_REG, NO_REG}, NO_REG, model->aluLatency, false, false, false};
+
+    // Dataflow from the ISA table; result latency by functional unit
+    uint8_t flags = ISA_TABLE[opcode].flags;
+    if (flags & ISA_READS_R1) node.reads[0] = r1;
+    if (flags & ISA_READS_R2) node.reads[1] = r2;
+    if (flags & ISA_WRITES_R1) node.writes = r1;
+    node.writesSreg = flags & ISA_WRITES_SREG;
+    node.accessesMemory = flags & (ISA_LOADS | ISA_STORES);
+    node.isBranch = flags & ISA_BRANCH;
+    if (flags & ISA_LOADS) {
+        node.latency = model->loadLatency;
+    } else if (unitOf(opcode) == UNIT_MUL) {
+        node.latency = model->mulLatency;
+    }
+    return node;
+}
+
+static bool nodeReads(const SchedNode* node, uint8_t reg) {
+    return reg != NO_REG && (node->reads[0] == reg || node->reads[1] == reg);
+}
+
+/**
+ * Minimum issue distance from an earlier node a to a later node b.
+ * @return: 0 if b may be placed before a, otherwise the required distance.
+ */
+static uint8_t dependence(const SchedNode* a, const SchedNode* b, const ScheduleModel* model) {
+    uint8_t distance = 0;
+    if (nodeReads(b, a->writes)) {
+        distance = a->latency + (b->isBranch ? model->branchEarly : 0);
+    }
+    if (distance == 0 && (nodeReads(a, b->writes) ||
+                          (a->writes != NO_REG && a->writes == b->writes) ||
+                          (a->writesSreg && b->writesSreg) ||
+                          (a->accessesMemory && b->accessesMemory))) {
+        distance = 1;
+    }
+    return distance;
+}
+
+// ================== List Scheduling ==================
+
+typedef struct {
+    int count;
+    SchedNode nodes[SCHEDULE_WINDOW];
+    uint8_t distance[SCHEDULE_WINDOW][SCHEDULE_WINDOW];   // [earlier][later]
+} Window;
+
+/**
+ * Predicted stall cycles when the window issues in the given order, assuming
+ * every register is ready on entry.
+ */
+static uint64_t countStalls(const Window* w, const int* order) {
+    int issueAt[SCHEDULE_WINDOW];
+    int previous = -1;
+    uint64_t stalls = 0;
+    for (int k = 0; k < w->count; k++) {
+        int j = order[k];
+        int issue = previous + 1;
+        for (int i = 0; i < j; i++) {
+            if (w->distance[i][j] && issueAt[i] + w->distance[i][j] > issue) {
+                issue = issueAt[i] + w->distance[i][j];
+            }
+        }
+        stalls += (uint64_t)(issue - previous - 1);
+        issueAt[j] = issue;
+        previous = issue;
+    }
+    return stalls;
+}
+
+/**
+ * Greedy list scheduling: each slot takes the node that can issue earliest,
+ * then the one on the longest remaining dependency path, then source order.
+ * A trailing branch always stays last.
+ */
+static void listSchedule(const Window* w, int* order) {
+    int height[SCHEDULE_WINDOW];
+    int issueAt[SCHEDULE_WINDOW];
+    bool placed[SCHEDULE_WINDOW] = {false};
+
+    for (int i = w->count - 1; i >= 0; i--) {
+        height[i] = 0;
+        for (int j = i + 1; j < w->count; j++) {
+            if (w->distance[i][j] && w->distance[i][j] + height[j] > height[i]) {
+                height[i] = w->distance[i][j] + height[j];
+            }
+        }
+    }
+
+    int last = w->count - 1;
+    bool pinLast = w->nodes[last].isBranch;
+    int next = 0;
+    for (int k = 0; k < w->count; k++) {
+        int best = -1;
+        int bestIssue = 0;
+        for (int j = 0; j < w->count; j++) {
+            if (placed[j] || (pinLast && j == last && k != last)) continue;
+
+            bool ready = true;
+            int issue = next;
+            for (int i = 0; i < j && ready; i++) {
+                if (!w->distance[i][j]) continue;
+                if (!placed[i]) {
+                    ready = false;
+                } else if (issueAt[i] + w->distance[i][j] > issue) {
+                    issue = issueAt[i] + w->distance[i][j];
+                }
+            }
+            if (!ready) continue;
+            if (best < 0 || issue < bestIssue || (issue == bestIssue && height[j] > height[best])) {
+                best = j;
+                bestIssue = issue;
+            }
+        }
+        order[k] = best;
+        placed[best] = true;
+        issueAt[best] = bestIssue;
+        next = bestIssue + 1;
+    }
+}
+
+/**
+ * Schedules instruction memory [start, end) as one window and rewrites it if
+ * the new order is predicted to stall less.
+ */
+static void scheduleWindow(uint16_t start, uint16_t end, const ScheduleModel* model,
+                           ScheduleReport* report) {
+    static SIM_THREAD_LOCAL Window w;
+    w.count = end - start;
+    for (int i = 0; i < w.count; i++) {
+        w.nodes[i] = describeNode(instructionMemory[start + i], model);
+        for (int j = 0; j < i; j++) {
+            w.distance[j][i] = dependence(&w.nodes[j], &w.nodes[i], model);
+        }
+    }
+
+    int original[SCHEDULE_WINDOW];
+    int order[SCHEDULE_WINDOW];
+    for (int i = 0; i < w.count; i++) original[i] = i;
+    listSchedule(&w, order);
+
+    uint64_t before = countStalls(&w, original);
+    uint64_t after = countStalls(&w, order);
+    report->stallsBefore += before;
+    if (after >= before) {
+        report->stallsAfter += before;
+        return;
+    }
+
+    report->stallsAfter += after;
+    report->rescheduled++;
+    for (int k = 0; k < w.count; k++) {
+        if (order[k] != k) report->moved++;
+        writeToMemory((uint16_t)(start + k), w.nodes[order[k]].word, 0);
+    }
+}
+
+// ================== Control Flow ==================
+
+static int8_t signExtend6(uint8_t value) {
+    return (int8_t)((value & 0x20) ? (value | 0xC0) : value);
+}
+
+/**
+ * Finds the value a register holds at pc if a MOVI in the same block
+ * (which starts at the nearest leader at or before pc) sets it.
+ * @return: true and the value in *value when the MOVI is found.
+ */
+static bool constantAt(uint16_t pc, uint8_t reg, const bool* leader, int8_t* value) {
+    static const ScheduleModel anyModel = DEFAULT_SCHEDULE_MODEL;
+    for (uint16_t at = pc; !leader[at]; at--) {
+        uint16_t word = instructionMemory[at - 1];
+        if (describeNode(word, &anyModel).writes == reg) {
+            if (((word >> 12) & 0x0F) != OP_MOVI) return false;
+            *value = signExtend6(word & 0x3F);
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * Marks block leaders in [0, end): the entry, branch targets and everything
+ * after a branch or barrier. Iterates because each resolved BR target can
+ * split the block that supplied another BR's operands.
+ * @return: false if a BR target cannot be determined statically.
+ */
+static bool findLeaders(uint16_t end, bool* leader, ScheduleReport* report) {
+    memset(leader, 0, (size_t)(end + 1) * sizeof(bool));
+    leader[0] = true;
+    for (uint16_t pc = 0; pc < end; pc++) {
+        uint16_t word = instructionMemory[pc];
+        uint8_t opcode = (word >> 12) & 0x0F;
+        if (isBarrier(word)) {
+            leader[pc] = true;
+            leader[pc + 1] = true;
+        } else if (isBranchOpcode(opcode)) {
+            leader[pc + 1] = true;
+            if (opcode == OP_BEQZ) {
+                int target = pc + 1 + signExtend6(word & 0x3F);
+                if (target >= 0 && target < end) leader[target] = true;
+            }
+        }
+    }
+
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (uint16_t pc = 0; pc < end; pc++) {
+            uint16_t word = instructionMemory[pc];
+            if (((word >> 12) & 0x0F) != OP_BR || isBarrier(word)) continue;
+
+            int8_t high, low;
+            if (!constantAt(pc, (word >> 6) & 0x3F, leader, &high) ||
+                !constantAt(pc, word & 0x3F, leader, &low)) {
+                snprintf(report->reason, sizeof(report->reason),
+                         "BR at %u has no static target", pc);
+                return false;
+            }
+            // Same arithmetic as execute_BR, including the sign of the low byte
+            uint16_t target = (uint16_t)((high << 8) | low);
+            if (target < end && !leader[target]) {
+                leader[target] = true;
+                changed = true;
+            }
+        }
+    }
+    return true;
+}
+
+// ================== Public Interface ==================
+
+/**
+ * Parses "key=value,..." over the default model.
+ * Keys: alu, mul, load (result latencies, at least 1) and branch.
+ * @return: 0 on success, -1 on an unknown key or a zero latency.
+ */
+int parseScheduleModel(const char* text, ScheduleModel* model) {
+    ScheduleModel defaults = DEFAULT_SCHEDULE_MODEL;
+    *model = defaults;
+
+    char buffer[128];
+    snprintf(buffer, sizeof(buffer), "%s", text);
+    for (char* item = strtok(buffer, ","); item; item = strtok(NULL, ",")) {
+        char* value = strchr(item, '=');
+        if (!value) return -1;
+        *value++ = '\0';
+        uint8_t number = (uint8_t)atoi(value);
+
+        if (strcmp(item, "alu") == 0) {
+            model->aluLatency = number;
+        } else if (strcmp(item, "mul") == 0) {
+            model->mulLatency = number;
+        } else if (strcmp(item, "load") == 0) {
+            model->loadLatency = number;
+        } else if (strcmp(item, "branch") == 0) {
+            model->branchEarly = number;
+        } else {
+            return -1;
+        }
+    }
+    return model->aluLatency && model->mulLatency && model->loadLatency ? 0 : -1;
+}
+
+/**
+ * Reorders the resident program block by block (see scheduler.h).
+ * @param model: Latencies the schedule is optimized for.
+ * @param report: Filled with what the pass did and the predicted stalls.
+ */
+void scheduleProgram(const ScheduleModel* model, ScheduleReport* report) {
+    static SIM_THREAD_LOCAL bool leader[INSTRUCTION_MEMORY_SIZE + 1];
+    memset(report, 0, sizeof(*report));
+
+    // Unused instruction memory holds HALT words; stop after the last real one
+    uint16_t end = 0;
+    for (uint16_t pc = 0; pc < INSTRUCTION_MEMORY_SIZE; pc++) {
+        if (instructionMemory[pc] != 0xFFFF) end = pc + 1;
+    }
+
+    if (!findLeaders(end, leader, report)) {
+        TRACE("[SCHED] Skipped: %s\n", report->reason);
+        return;
+    }
+    report->applied = true;
+
+    uint16_t start = 0;
+    while (start < end) {
+        uint16_t stop = start + 1;
+        while (stop < end && !leader[stop]) stop++;
+        report->blocks++;
+
+        if (!isBarrier(instructionMemory[start])) {
+            for (uint16_t w = start; w < stop; w += SCHEDULE_WINDOW) {
+                uint16_t windowEnd = stop - w > SCHEDULE_WINDOW ? w + SCHEDULE_WINDOW : stop;
+                scheduleWindow(w, windowEnd, model, report);
+            }
+        }
+        start = stop;
+    }
+    TRACE("[SCHED] %d of %d blocks rescheduled, predicted stalls %llu -> %llu\n",
+          report->rescheduled, report->blocks,
+          (unsigned long long)report->stallsBefore, (unsigned long long)report->stallsAfter);
+}
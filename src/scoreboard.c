@@ -0,0 +1,176 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../includes/scoreboard.h"
+
+// ================== Scoreboard State ==================
+SIM_THREAD_LOCAL Scoreboard scoreboard;
+
+// EX latency per opcode; all 1 is the single-cycle machine
+static SIM_THREAD_LOCAL uint8_t latency[OPCODE_COUNT] = {1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1};
+static SIM_THREAD_LOCAL bool multiCycle = false;
+
+static const char* UNIT_NAMES[UNIT_COUNT] = {"ALU", "MUL", "MEM", "BRANCH"};
+
+// Unit per opcode; reserved opcodes stay 0 (UNIT_ALU)
+#define UNIT_ENTRY(name, opcode, operand, flags, unit) [opcode] = UNIT_##unit,
+static const uint8_t UNIT_TABLE[OPCODE_COUNT] = {
+    ISA_INSTRUCTIONS(UNIT_ENTRY)
+};
+
+#define NO_REG 0xFF
+
+// Source and destination registers of an instruction, NO_REG where unused
+static void operandsOf(uint8_t opcode, uint8_t r1, uint8_t r2,
+                       uint8_t* src1, uint8_t* src2, uint8_t* dest) {
+    uint8_t flags = ISA_TABLE[opcode & 0x0F].flags;
+    *src1 = flags & ISA_READS_R1 ? r1 : NO_REG;
+    *src2 = flags & ISA_READS_R2 ? r2 : NO_REG;
+    *dest = flags & ISA_WRITES_R1 ? r1 : NO_REG;
+}
+
+static bool pending(uint8_t reg, uint64_t cycle) {
+    return reg != NO_REG && scoreboard.ready[reg] > cycle;
+}
+
+// ================== Configuration ==================
+
+/**
+ * Clears the scoreboard and its counters (latencies are kept).
+ */
+void initScoreboard() {
+    memset(&scoreboard, 0, sizeof(scoreboard));
+}
+
+/**
+ * Sets the EX latency of every opcode. 0 counts as 1; branches always take
+ * one cycle since fetch is redirected from EX.
+ */
+void setOpcodeLatencies(const uint8_t latencies[OPCODE_COUNT]) {
+    multiCycle = false;
+    for (int op = 0; op < OPCODE_COUNT; op++) {
+        latency[op] = latencies[op] > 1 && unitOf((uint8_t)op) != UNIT_BRANCH ? latencies[op] : 1;
+        multiCycle = multiCycle || latency[op] > 1;
+    }
+}
+
+/**
+ * True if any opcode takes more than one cycle in EX.
+ */
+bool hasMultiCycleOps() {
+    return multiCycle;
+}
+
+/**
+ * Parses "MNEMONIC=cycles,..." (e.g. "MUL=3,LDR=2"); unlisted opcodes take 1.
+ * @return: 0 on success, -1 on an unknown mnemonic or a latency outside 1-255.
+ */
+int parseLatencies(const char* text, uint8_t latencies[OPCODE_COUNT]) {
+    memset(latencies, 1, OPCODE_COUNT);
+
+    char buffer[256];
+    snprintf(buffer, sizeof(buffer), "%s", text);
+    for (char* item = strtok(buffer, ","); item; item = strtok(NULL, ",")) {
+        char* value = strchr(item, '=');
+        if (!value) return -1;
+        *value++ = '\0';
+        int cycles = atoi(value);
+        int op = findOpcode(item);
+        if (op < 0 || cycles < 1 || cycles > 255) return -1;
+        latencies[op] = (uint8_t)cycles;
+    }
+    return 0;
+}
+
+FunctionalUnit unitOf(uint8_t opcode) {
+    return (FunctionalUnit)UNIT_TABLE[opcode & 0x0F];
+}
+
+// ================== Issue Logic ==================
+
+/**
+ * Decides whether the instruction in ID/EX may issue in this cycle.
+ * @return: HAZARD_NONE, or the first hazard that holds it back.
+ */
+IssueHazard checkIssue(uint8_t opcode, uint8_t r1, uint8_t r2, uint64_t cycle) {
+    if (!multiCycle) return HAZARD_NONE;
+
+    uint8_t src1, src2, dest;
+    operandsOf(opcode, r1, r2, &src1, &src2, &dest);
+    if (pending(src1, cycle) || pending(src2, cycle)) return HAZARD_RAW;
+    if (pending(dest, cycle)) return HAZARD_WAW;
+    if (scoreboard.busyUntil[unitOf(opcode)] >= cycle) return HAZARD_STRUCTURAL;
+    return HAZARD_NONE;
+}
+
+/**
+ * Occupies the instruction's unit and marks its destination pending.
+ * @param cycle: Cycle in which the instruction enters EX.
+ */
+void recordIssue(uint8_t opcode, uint8_t r1, uint64_t cycle) {
+    uint8_t unit = UNIT_TABLE[opcode & 0x0F];
+    uint8_t cycles = latency[opcode & 0x0F];
+    scoreboard.stats.issued[unit]++;
+    scoreboard.stats.busyCycles[unit] += cycles;
+
+    // Single-cycle results are ready for the next issue, which the ID
+    // interlock for branches already covers; only the counters matter
+    if (!multiCycle) return;
+
+    scoreboard.busyUntil[unit] = cycle + cycles - 1;
+    if (scoreboard.busyUntil[unit] > scoreboard.lastBusy) {
+        scoreboard.lastBusy = scoreboard.busyUntil[unit];
+    }
+
+    uint8_t src1, src2, dest;
+    operandsOf(opcode, r1, 0, &src1, &src2, &dest);
+    if (dest != NO_REG) {
+        scoreboard.ready[dest] = cycle + cycles;
+    }
+}
+
+void recordStall(IssueHazard hazard) {
+    switch (hazard) {
+        case HAZARD_RAW:        scoreboard.stats.rawStalls++; break;
+        case HAZARD_WAW:        scoreboard.stats.wawStalls++; break;
+        case HAZARD_STRUCTURAL: scoreboard.stats.structuralStalls++; break;
+        default: break;
+    }
+}
+
+/**
+ * True if an instruction still in a unit will write reg after this cycle.
+ */
+bool isRegisterPending(uint8_t reg, uint64_t cycle) {
+    return pending(reg, cycle);
+}
+
+/**
+ * True once no unit holds an instruction beyond this cycle.
+ */
+bool areUnitsIdle(uint64_t cycle) {
+    return scoreboard.lastBusy <= cycle;
+}
+
+/**
+ * Prints per-unit occupancy and the ID stall breakdown, with the latencies
+ * currently configured.
+ * @param cycles: Total cycles of the run, for the occupancy percentages.
+ */
+void printScoreboardReport(const ScoreboardStats* s, uint64_t cycles) {
+    printf("\n===== Functional Units =====\n");
+    printf("%-8s %8s %12s %12s %10s\n", "unit", "latency", "issued", "busy cycles", "occupancy");
+    for (int unit = 0; unit < UNIT_COUNT; unit++) {
+        uint8_t slowest = 1;
+        for (int op = 0; op < OPCODE_COUNT; op++) {
+            if (ISA_TABLE[op].name && (int)unitOf((uint8_t)op) == unit && latency[op] > slowest) {
+                slowest = latency[op];
+            }
+        }
+        printf("%-8s %8u %12llu %12llu %9.1f%%\n", UNIT_NAMES[unit], slowest,
+               (unsigned long long)s->issued[unit], (unsigned long long)s->busyCycles[unit],
+               cycles ? 100.0 * s->busyCycles[unit] / cycles : 0.0);
+    }
+    printf("ID stalls: %llu RAW, %llu WAW, %llu structural\n", (unsigned long long)s->rawStalls,
+           (unsigned long long)s->wawStalls, (unsigned long long)s->structuralStalls);
+}
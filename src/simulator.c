@@ -0,0 +1,547 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../includes/simulator.h"
+#include "../includes/state.h"
+#include "../includes/pipeline.h"
+#include "../includes/parser.h"
+#include "../includes/block_cache.h"
+#include "../includes/profile.h"
+#include "../includes/activity.h"
+#include "../includes/stream_io.h"
+
+// ================== Simulator Instance ==================
+struct Simulator {
+    SimState state;              // Machine state while another instance is resident
+    SimCallbacks callbacks;
+    bool verbose;
+    SimEngine engine;
+    SimBranchStage branchStage;
+    SimPipelineDepth depth;
+    uint8_t latencies[OPCODE_COUNT];    // EX cycles per opcode, 0 for the default of 1
+    uint64_t (*activity)[ACT_COUNT];    // ACTIVITY_ROWS per-PC event counters
+    bool countActivity;                 // Fill activity, latch toggles included
+    StreamDevice* streams;              // Memory-mapped I/O ports, or NULL
+    bool breakpoints[INSTRUCTION_MEMORY_SIZE];
+    int breakpointCount;
+};
+
+// Instance whose state currently lives in this thread's module globals
+static SIM_THREAD_LOCAL Simulator* resident = NULL;
+
+/**
+ * Makes sim the resident instance, parking the previous one's state.
+ */
+static void activate(Simulator* sim) {
+    if (resident == sim) return;
+    if (resident) {
+        captureState(&resident->state);
+    }
+    restoreState(&sim->state);
+    setTraceCallbacks(&sim->callbacks);
+    setTraceStdout(sim->verbose);
+    setBranchInDecode(sim->branchStage == SIM_BRANCH_IN_ID);
+    setOpcodeLatencies(sim->latencies);
+    setActivityTable(sim->countActivity ? sim->activity : NULL);
+    setLatchToggleCounting(sim->countActivity);
+    setStreamDevice(sim->streams);
+    resident = sim;
+}
+
+// ================== Pipeline Model Dispatch ==================
+
+// Entry points of a pipeline model, indexed by SimPipelineDepth
+typedef struct {
+    bool (*cycle)();
+    bool (*drained)();
+    uint64_t (*cycles)();
+    uint64_t (*instructions)();
+} PipelineModel;
+
+static const PipelineModel PIPELINE_MODELS[] = {
+    [SIM_PIPELINE_3_STAGE] = {pipelineCycle, isPipelineDrained, getCycleCount, getInstructionCount},
+    [SIM_PIPELINE_5_STAGE] = {pipeline5Cycle, isPipeline5Drained, getPipeline5Cycles, getPipeline5Instructions},
+};
+
+static bool isFiveStage(const Simulator* sim) {
+    return sim->depth == SIM_PIPELINE_5_STAGE;
+}
+
+// True if the instruction about to enter EX sits on a breakpoint
+static bool atBreakpoint(const Simulator* sim) {
+    if (sim->breakpointCount == 0) return false;
+    uint16_t address;
+    if (isFiveStage(sim)) {
+        if (!peekPipeline5Execute(&address)) return false;
+    } else {
+        if (!ID_EX.valid) return false;
+        address = ID_EX.nextPC - 1;
+    }
+    return address < INSTRUCTION_MEMORY_SIZE && sim->breakpoints[address];
+}
+
+// The block engine skips per-cycle trace text, register-write and retirement
+// events, breakpoints and activity counts, assumes single-cycle units and the
+// three-stage timing and reads data memory directly, past the I/O ports; when
+// any of them is wanted the pipeline model runs instead
+static bool canRunBlocks(const Simulator* sim) {
+    return sim->engine == SIM_ENGINE_BLOCKS && !isFiveStage(sim) && !traceActive && sim->breakpointCount == 0 &&
+           !sim->callbacks.onRegisterWrite && !sim->callbacks.onRetire && !hasMultiCycleOps() && !sim->streams &&
+           !sim->countActivity;
+}
+
+// ================== Lifecycle ==================
+
+/**
+ * Creates a simulator with empty memories and cleared registers.
+ * @param callbacks: Event callbacks to copy, or NULL for none.
+ * @return: The new instance, or NULL if out of memory.
+ */
+Simulator* simCreate(const SimCallbacks* callbacks) {
+    Simulator* sim = calloc(1, sizeof(Simulator));
+    if (!sim) return NULL;
+    sim->activity = calloc(ACTIVITY_ROWS, sizeof(*sim->activity));
+    if (!sim->activity) {
+        free(sim);
+        return NULL;
+    }
+    if (callbacks) {
+        sim->callbacks = *callbacks;
+    }
+    simReset(sim);
+    return sim;
+}
+
+/**
+ * Releases a simulator instance.
+ */
+void simDestroy(Simulator* sim) {
+    if (!sim) return;
+    if (resident == sim) {
+        resident = NULL;
+        setActivityTable(NULL);
+        setStreamDevice(NULL);
+    }
+    free(sim->activity);
+    free(sim);
+    PROFILE_FLUSH();
+}
+
+/**
+ * Returns the machine to its power-on state. Breakpoints are kept.
+ */
+void simReset(Simulator* sim) {
+    activate(sim);
+    initMemory();
+    initRegisters();
+    initPipeline();
+    initPipeline5();
+}
+
+/**
+ * Enables or disables the verbose per-cycle trace on stdout.
+ */
+void simSetVerbose(Simulator* sim, bool verbose) {
+    sim->verbose = verbose;
+    if (resident == sim) {
+        setTraceStdout(verbose);
+    }
+}
+
+/**
+ * Selects the execution engine used by simRun().
+ */
+void simSetEngine(Simulator* sim, SimEngine engine) {
+    sim->engine = engine;
+}
+
+/**
+ * Selects whether branches are resolved in EX or in ID. Set it before
+ * running; a branch already in flight finishes in the stage it started with.
+ */
+void simSetBranchStage(Simulator* sim, SimBranchStage stage) {
+    sim->branchStage = stage;
+    if (resident == sim) {
+        setBranchInDecode(stage == SIM_BRANCH_IN_ID);
+    }
+}
+
+/**
+ * Enables the activity counters (see activity.h), latch toggles included.
+ * Counting costs a little on every event, so it is off by default, and while
+ * it is on the block engine is not used. Enabling clears the counters; so
+ * does every program load and reset while enabled.
+ */
+void simSetActivityCounting(Simulator* sim, bool enabled) {
+    if (enabled && !sim->countActivity) {
+        memset(sim->activity, 0, sizeof(ActivityCounts));
+    }
+    sim->countActivity = enabled;
+    if (resident == sim) {
+        setActivityTable(enabled ? sim->activity : NULL);
+        setLatchToggleCounting(enabled);
+    }
+}
+
+/**
+ * Selects the three- or five-stage pipeline model. Both start empty at
+ * reset, so choose before loading a program.
+ */
+void simSetPipelineDepth(Simulator* sim, SimPipelineDepth depth) {
+    sim->depth = depth;
+}
+
+/**
+ * Sets how many cycles an opcode occupies its functional unit (see
+ * scoreboard.h). 0 or 1 is single-cycle; BEQZ and BR are always single-cycle.
+ */
+void simSetLatency(Simulator* sim, uint8_t opcode, uint8_t cycles) {
+    if (opcode >= OPCODE_COUNT) return;
+    sim->latencies[opcode] = cycles;
+    if (resident == sim) {
+        setOpcodeLatencies(sim->latencies);
+    }
+}
+
+// ================== Program Loading ==================
+
+/**
+ * Resets the machine and assembles a program file into instruction memory.
+ * @return: Number of instructions loaded, or -1 if the file cannot be read.
+ */
+int simLoadFile(Simulator* sim, const char* filename) {
+    simReset(sim);
+    return parseInstructionFile(filename);
+}
+
+/**
+ * Resets the machine and assembles program source held in memory.
+ * @return: Number of instructions loaded.
+ */
+int simLoadSource(Simulator* sim, const char* source, size_t length) {
+    simReset(sim);
+    return parseInstructionBuffer(source, length);
+}
+
+/**
+ * Resets the machine and copies already-assembled instruction words into
+ * instruction memory, followed by a HALT if there is room.
+ * @return: Number of instructions loaded.
+ */
+int simLoadImage(Simulator* sim, const uint16_t* words, size_t count) {
+    simReset(sim);
+    if (count > INSTRUCTION_MEMORY_SIZE) {
+        count = INSTRUCTION_MEMORY_SIZE;
+    }
+    for (size_t i = 0; i < count; i++) {
+        writeToMemory((uint16_t)i, words[i], 0);
+    }
+    if (count < INSTRUCTION_MEMORY_SIZE) {
+        writeToMemory((uint16_t)count, 0xFFFF, 0);
+    }
+    return (int)count;
+}
+
+/**
+ * Reorders the loaded program's basic blocks for the given latency model.
+ * @param report: Receives what was changed and the predicted stalls.
+ */
+void simSchedule(Simulator* sim, const ScheduleModel* model, ScheduleReport* report) {
+    activate(sim);
+    if (sim->streams) {
+        // Loads from the ports have side effects and must keep their order
+        memset(report, 0, sizeof(*report));
+        snprintf(report->reason, sizeof(report->reason), "streaming I/O ports are attached");
+        return;
+    }
+    scheduleProgram(model, report);
+}
+
+// ================== Initial State ==================
+
+void simWriteRegister(Simulator* sim, uint8_t regNum, int8_t value) {
+    activate(sim);
+    writeRegister(regNum, value);
+}
+
+/**
+ * Copies a block into data memory, clipped to the end of memory.
+ * @return: Number of bytes written.
+ */
+size_t simWriteDataMemory(Simulator* sim, uint16_t address, const int8_t* data, size_t length) {
+    activate(sim);
+    if (address >= DATA_MEMORY_SIZE) return 0;
+    if (length > (size_t)(DATA_MEMORY_SIZE - address)) {
+        length = DATA_MEMORY_SIZE - address;
+    }
+    memcpy(&dataMemory[address], data, length);
+    return length;
+}
+
+/**
+ * Fills data memory from a raw binary file (see loadDataMemoryFile).
+ * @return: Number of bytes loaded, or -1 if the file cannot be read or does
+ *          not fit.
+ */
+int simLoadDataFile(Simulator* sim, const char* filename, uint16_t address) {
+    activate(sim);
+    return loadDataMemoryFile(filename, address);
+}
+
+/**
+ * Maps the streaming I/O ports (see stream_io.h) to a device, or back to data
+ * memory with NULL. The caller owns the device and flushes its output.
+ */
+void simAttachStreams(Simulator* sim, StreamDevice* device) {
+    sim->streams = device;
+    if (resident == sim) {
+        setStreamDevice(device);
+    }
+}
+
+// ================== Execution ==================
+
+/**
+ * Advances the pipeline by up to the given number of cycles.
+ * @return: Number of cycles actually run (fewer if the program halted).
+ */
+uint64_t simStep(Simulator* sim, uint64_t cycles) {
+    activate(sim);
+    const PipelineModel* model = &PIPELINE_MODELS[sim->depth];
+    uint64_t ran = 0;
+    while (ran < cycles && !model->drained()) {
+        model->cycle();
+        ran++;
+    }
+    return ran;
+}
+
+/**
+ * Runs until the program halts, a breakpoint is reached or maxCycles elapse.
+ * A breakpoint at the instruction about to execute is ignored for the first
+ * cycle so a stopped run can be resumed.
+ * @param maxCycles: Cycle budget for this call, 0 for unlimited.
+ */
+SimStopReason simRun(Simulator* sim, uint64_t maxCycles) {
+    activate(sim);
+    const PipelineModel* model = &PIPELINE_MODELS[sim->depth];
+    uint64_t start = model->cycles();
+    if (canRunBlocks(sim)) {
+        runBlocks(maxCycles ? start + maxCycles : 0);
+    }
+    while (true) {
+        uint64_t ran = model->cycles() - start;
+        if (model->drained()) return SIM_HALTED;
+        if (maxCycles && ran >= maxCycles) return SIM_CYCLE_LIMIT;
+        if (ran > 0 && atBreakpoint(sim)) return SIM_BREAKPOINT;
+        model->cycle();
+    }
+}
+
+/**
+ * Computes how many cycles the program would take from here, on the
+ * functional path with the pipeline timing in closed form. Registers,
+ * memory and pipeline are restored afterwards and no callbacks fire.
+ * @param maxCycles: Cycle budget, 0 for unlimited.
+ * @return: false if multi-cycle latencies are set, the five-stage model is
+ *          selected (not modelled) or streams are attached (their input
+ *          cannot be put back).
+ */
+bool simEstimateCycles(Simulator* sim, uint64_t maxCycles, CycleEstimate* estimate) {
+    static SIM_THREAD_LOCAL int8_t savedData[DATA_MEMORY_SIZE];
+    int8_t savedRegisters[REGISTER_COUNT];
+    if (isFiveStage(sim) || sim->streams) return false;
+    activate(sim);
+
+    memcpy(savedRegisters, registers, sizeof(registers));
+    memcpy(savedData, dataMemory, sizeof(dataMemory));
+    uint8_t savedSREG = SREG;
+    setTraceCallbacks(NULL);
+
+    bool estimated = estimateCycles(maxCycles ? getCycleCount() + maxCycles : 0, estimate);
+
+    setTraceCallbacks(&sim->callbacks);
+    memcpy(registers, savedRegisters, sizeof(registers));
+    memcpy(dataMemory, savedData, sizeof(dataMemory));
+    SREG = savedSREG;
+    return estimated;
+}
+
+// ================== Result Memoization ==================
+
+/**
+ * Hashes the run simRun(sim, maxCycles) would perform from the current
+ * state: the instruction memory, the non-zero registers, SREG, PC and data
+ * memory, and the settings that change results or timing. The engine is
+ * left out; both engines produce the same results and counts.
+ * @return: false if the run cannot be keyed: the machine has already run
+ *          cycles (latches in flight are not part of the key), has
+ *          breakpoints set or reads a stream.
+ */
+bool simRunKey(Simulator* sim, uint64_t maxCycles, RunKey* key) {
+    activate(sim);
+    if (sim->breakpointCount != 0 || sim->streams || PIPELINE_MODELS[sim->depth].cycles() != 0) return false;
+
+    static const char TAG[] = "sim-run-1";
+    RunKeyBuilder builder;
+    beginRunKey(&builder);
+    addToRunKey(&builder, TAG, sizeof(TAG));
+    addToRunKey(&builder, instructionMemory, sizeof(instructionMemory));
+    for (uint16_t i = 0; i < REGISTER_COUNT; i++) {
+        if (registers[i] != 0) {
+            addToRunKey(&builder, &i, sizeof(i));
+            addToRunKey(&builder, &registers[i], 1);
+        }
+    }
+    uint16_t marker = 0xFFFF;
+    addToRunKey(&builder, &marker, sizeof(marker));
+    for (uint16_t i = 0; i < DATA_MEMORY_SIZE; i++) {
+        if (dataMemory[i] != 0) {
+            addToRunKey(&builder, &i, sizeof(i));
+            addToRunKey(&builder, &dataMemory[i], 1);
+        }
+    }
+    addToRunKey(&builder, &marker, sizeof(marker));
+
+    uint8_t settings[4 + OPCODE_COUNT] = {SREG, (uint8_t)PC, (uint8_t)(PC >> 8), 0};
+    settings[3] = (uint8_t)(sim->depth << 4 | sim->branchStage);
+    for (int op = 0; op < OPCODE_COUNT; op++) {
+        settings[4 + op] = sim->latencies[op] > 1 ? sim->latencies[op] : 1;
+    }
+    addToRunKey(&builder, settings, sizeof(settings));
+    addToRunKey(&builder, &maxCycles, sizeof(maxCycles));
+    finishRunKey(&builder, key);
+    return true;
+}
+
+/**
+ * Copies the final state and counts of a run into a cacheable result. The
+ * caller-defined counters are cleared.
+ */
+void simCaptureResult(Simulator* sim, SimStopReason reason, CachedResult* result) {
+    activate(sim);
+    memset(result, 0, sizeof(*result));
+    result->reason = (uint8_t)reason;
+    result->sreg = SREG;
+    result->pc = PC;
+    result->cycles = PIPELINE_MODELS[sim->depth].cycles();
+    result->instructions = PIPELINE_MODELS[sim->depth].instructions();
+    memcpy(result->registers, registers, sizeof(registers));
+    memcpy(result->dataMemory, dataMemory, sizeof(dataMemory));
+}
+
+/**
+ * Makes a cached result's registers, SREG, PC and data memory the machine's
+ * state, as if the run had happened. Pipeline counters are not changed.
+ */
+void simApplyResult(Simulator* sim, const CachedResult* result) {
+    activate(sim);
+    memcpy(registers, result->registers, sizeof(registers));
+    memcpy(dataMemory, result->dataMemory, sizeof(dataMemory));
+    SREG = result->sreg;
+    PC = result->pc;
+}
+
+void simSetBreakpoint(Simulator* sim, uint16_t address, bool enabled) {
+    if (address >= INSTRUCTION_MEMORY_SIZE || sim->breakpoints[address] == enabled) return;
+    sim->breakpoints[address] = enabled;
+    sim->breakpointCount += enabled ? 1 : -1;
+}
+
+void simClearBreakpoints(Simulator* sim) {
+    memset(sim->breakpoints, 0, sizeof(sim->breakpoints));
+    sim->breakpointCount = 0;
+}
+
+// ================== State Readout ==================
+
+void simReadRegisters(Simulator* sim, int8_t out[REGISTER_COUNT]) {
+    activate(sim);
+    memcpy(out, registers, sizeof(registers));
+}
+
+uint8_t simReadSREG(Simulator* sim) {
+    activate(sim);
+    return SREG;
+}
+
+uint16_t simReadPC(Simulator* sim) {
+    activate(sim);
+    return PC;
+}
+
+/**
+ * Copies data memory into out, clipped to the end of memory.
+ * @return: Number of bytes copied.
+ */
+size_t simReadDataMemory(Simulator* sim, uint16_t address, int8_t* out, size_t length) {
+    activate(sim);
+    if (address >= DATA_MEMORY_SIZE) return 0;
+    if (length > (size_t)(DATA_MEMORY_SIZE - address)) {
+        length = DATA_MEMORY_SIZE - address;
+    }
+    memcpy(out, &dataMemory[address], length);
+    return length;
+}
+
+/**
+ * Copies instruction memory words into out, clipped to the end of memory.
+ * @return: Number of words copied.
+ */
+size_t simReadInstructionMemory(Simulator* sim, uint16_t address, uint16_t* out, size_t length) {
+    activate(sim);
+    if (address >= INSTRUCTION_MEMORY_SIZE) return 0;
+    if (length > (size_t)(INSTRUCTION_MEMORY_SIZE - address)) {
+        length = INSTRUCTION_MEMORY_SIZE - address;
+    }
+    memcpy(out, &instructionMemory[address], length * sizeof(uint16_t));
+    return length;
+}
+
+uint64_t simCycleCount(Simulator* sim) {
+    activate(sim);
+    return PIPELINE_MODELS[sim->depth].cycles();
+}
+
+uint64_t simInstructionCount(Simulator* sim) {
+    activate(sim);
+    return PIPELINE_MODELS[sim->depth].instructions();
+}
+
+bool simIsHalted(Simulator* sim) {
+    activate(sim);
+    return PIPELINE_MODELS[sim->depth].drained();
+}
+
+/**
+ * Copies the functional-unit occupancy and issue-stall counters. Only the
+ * pipeline engine updates them.
+ */
+void simReadUnitStats(Simulator* sim, ScoreboardStats* out) {
+    activate(sim);
+    *out = scoreboard.stats;
+}
+
+/**
+ * Copies the per-PC activity counters. Only the pipeline engine updates them.
+ */
+void simReadActivity(Simulator* sim, ActivityCounts out) {
+    activate(sim);
+    memcpy(out, sim->activity, sizeof(ActivityCounts));
+}
+
+/**
+ * Copies the five-stage model's stall, flush and forwarding counters.
+ */
+void simReadPipeline5Stats(Simulator* sim, Pipeline5Stats* out) {
+    activate(sim);
+    *out = *getPipeline5Stats();
+}
+
+void simPrintState(Simulator* sim) {
+    activate(sim);
+    PROFILE_BEGIN(dump);
+    printRegisterDump();
+    printMemoryDump();
+    PROFILE_END(dump, PROFILE_DUMP);
+}
@@ -0,0 +1,32 @@
+#include <string.h>
+#include "../includes/state.h"
+#include "../includes/block_cache.h"
+
+/**
+ * Copies the live simulator state into a snapshot.
+ * @param state: Destination snapshot.
+ */
+void captureState(SimState* state) {
+    memcpy(state->registers, registers, sizeof(state->registers));
+    state->sreg = SREG;
+    state->pc = PC;
+    memcpy(state->instructionMemory, instructionMemory, sizeof(state->instructionMemory));
+    memcpy(state->dataMemory, dataMemory, sizeof(state->dataMemory));
+    savePipeline(&state->pipeline);
+    savePipeline5(&state->pipeline5);
+}
+
+/**
+ * Makes a snapshot the live simulator state.
+ * @param state: Snapshot to restore.
+ */
+void restoreState(const SimState* state) {
+    memcpy(registers, state->registers, sizeof(registers));
+    SREG = state->sreg;
+    PC = state->pc;
+    memcpy(instructionMemory, state->instructionMemory, sizeof(instructionMemory));
+    flushBlockCache();
+    memcpy(dataMemory, state->dataMemory, sizeof(dataMemory));
+    restorePipeline(&state->pipeline);
+    restorePipeline5(&state->pipeline5);
+}
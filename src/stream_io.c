@@ -0,0 +1,94 @@
+#include <errno.h>
+#include <unistd.h>
+#include "../includes/stream_io.h"
+#include "../includes/trace.h"
+
+SIM_THREAD_LOCAL StreamDevice* activeStreams = NULL;
+
+/**
+ * Prepares a device over open file descriptors. The caller keeps ownership
+ * of the descriptors.
+ * @param inFd: Input the guest reads, or -1 for none.
+ * @param outFd: Where the guest's output goes, or -1 to discard it.
+ */
+void initStreamDevice(StreamDevice* device, int inFd, int outFd) {
+    device->inFd = inFd;
+    device->outFd = outFd;
+    device->inPos = 0;
+    device->inLength = 0;
+    device->outLength = 0;
+    device->inEnd = inFd < 0;
+    device->outError = false;
+    device->bytesIn = 0;
+    device->bytesOut = 0;
+}
+
+void setStreamDevice(StreamDevice* device) {
+    activeStreams = device;
+}
+
+// Makes at least one input byte available unless the input has ended
+static bool fillInput(StreamDevice* device) {
+    if (device->inPos < device->inLength) return true;
+    while (!device->inEnd) {
+        ssize_t got = read(device->inFd, device->inBuffer, sizeof(device->inBuffer));
+        if (got > 0) {
+            device->inPos = 0;
+            device->inLength = (size_t)got;
+            return true;
+        }
+        if (got < 0 && errno == EINTR) continue;
+        device->inEnd = true;
+    }
+    return false;
+}
+
+/**
+ * Writes the buffered output to the output descriptor.
+ * @return: 0 on success, -1 if any output was lost.
+ */
+int flushStreamOutput(StreamDevice* device) {
+    size_t done = 0;
+    while (done < device->outLength && !device->outError) {
+        if (device->outFd < 0) break;
+        ssize_t wrote = write(device->outFd, device->outBuffer + done, device->outLength - done);
+        if (wrote > 0) {
+            done += (size_t)wrote;
+        } else if (wrote < 0 && errno != EINTR) {
+            device->outError = true;
+        }
+    }
+    device->outLength = 0;
+    return device->outError ? -1 : 0;
+}
+
+/**
+ * Guest load from a port (see isStreamPort).
+ * @return: The port's value.
+ */
+int8_t readStreamPort(uint16_t address) {
+    StreamDevice* device = activeStreams;
+    int8_t value = 0;
+    if (address == STREAM_IN_READY) {
+        value = fillInput(device) ? 1 : 0;
+    } else if (address == STREAM_IN_DATA && fillInput(device)) {
+        value = (int8_t)device->inBuffer[device->inPos++];
+        device->bytesIn++;
+    }
+    TRACE("[IO] Port [0x%04X] -> %d (0x%02X)\n", address, value, (uint8_t)value);
+    return value;
+}
+
+/**
+ * Guest store to a port (see isStreamPort).
+ */
+void writeStreamPort(uint16_t address, int8_t value) {
+    StreamDevice* device = activeStreams;
+    TRACE("[IO] Port [0x%04X] = %d (0x%02X)\n", address, value, (uint8_t)value);
+    if (address != STREAM_OUT_DATA) return;
+    if (device->outLength == sizeof(device->outBuffer)) {
+        flushStreamOutput(device);
+    }
+    device->outBuffer[device->outLength++] = (uint8_t)value;
+    device->bytesOut++;
+}
@@ -0,0 +1,55 @@
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+#include "../includes/trace.h"
+
+// Trace Definitions
+SIM_THREAD_LOCAL SimCallbacks traceCallbacks;
+SIM_THREAD_LOCAL bool traceActive = false;
+static SIM_THREAD_LOCAL bool traceStdout = false;
+
+static void updateTraceActive() {
+    traceActive = traceStdout || traceCallbacks.onLog != NULL;
+}
+
+/**
+ * Enables or disables echoing trace text to stdout.
+ * @param enabled: true to print the verbose per-cycle trace.
+ */
+void setTraceStdout(bool enabled) {
+    traceStdout = enabled;
+    updateTraceActive();
+}
+
+/**
+ * Installs the event callbacks.
+ * @param callbacks: Callback table to copy, or NULL to remove all callbacks.
+ */
+void setTraceCallbacks(const SimCallbacks* callbacks) {
+    if (callbacks) {
+        traceCallbacks = *callbacks;
+    } else {
+        memset(&traceCallbacks, 0, sizeof(traceCallbacks));
+    }
+    updateTraceActive();
+}
+
+/**
+ * Formats trace text and sends it to stdout and/or the onLog callback.
+ * Use the TRACE macro so nothing is formatted while tracing is off.
+ */
+void tracef(const char* format, ...) {
+    char text[512];
+    va_list args;
+
+    va_start(args, format);
+    vsnprintf(text, sizeof(text), format, args);
+    va_end(args);
+
+    if (traceStdout) {
+        fputs(text, stdout);
+    }
+    if (traceCallbacks.onLog) {
+        traceCallbacks.onLog(traceCallbacks.user, text);
+    }
+}
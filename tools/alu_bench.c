@@ -0,0 +1,202 @@
+#include <stdio.h>
+#include <time.h>
+#include "../includes/alu_tables.h"
+
+/**
+ * ALU verification bench.
+ * Compiles src/instruction_set.c twice into this program, once with the
+ * branching flag logic and once with the tables, whatever ALU= the library
+ * was built with. Every 8-bit operand combination of ADD/SUB/MUL/EOR/ANDI/
+ * SAL/SAR is checked: the table entries and the table backend's execute_*
+ * against the branching execute_*. Reports ns/op of both execute_* paths.
+ */
+
+#ifdef USE_ALU_TABLES
+#define LIBRARY_BACKEND "tables"
+#else
+#define LIBRARY_BACKEND "branching flag logic"
+#endif
+
+// Branching reference backend, as branch_<NAME>
+#undef USE_ALU_TABLES
+#define execute_ADD  branch_ADD
+#define execute_SUB  branch_SUB
+#define execute_MUL  branch_MUL
+#define execute_EOR  branch_EOR
+#define execute_BR   branch_BR
+#define execute_MOVI branch_MOVI
+#define execute_BEQZ branch_BEQZ
+#define execute_ANDI branch_ANDI
+#define execute_SAL  branch_SAL
+#define execute_SAR  branch_SAR
+#define execute_LDR  branch_LDR
+#define execute_STR  branch_STR
+#include "../src/instruction_set.c"
+#undef execute_ADD
+#undef execute_SUB
+#undef execute_MUL
+#undef execute_EOR
+#undef execute_BR
+#undef execute_MOVI
+#undef execute_BEQZ
+#undef execute_ANDI
+#undef execute_SAL
+#undef execute_SAR
+#undef execute_LDR
+#undef execute_STR
+
+// Table backend, as table_<NAME>
+#define USE_ALU_TABLES
+#define execute_ADD  table_ADD
+#define execute_SUB  table_SUB
+#define execute_MUL  table_MUL
+#define execute_EOR  table_EOR
+#define execute_BR   table_BR
+#define execute_MOVI table_MOVI
+#define execute_BEQZ table_BEQZ
+#define execute_ANDI table_ANDI
+#define execute_SAL  table_SAL
+#define execute_SAR  table_SAR
+#define execute_LDR  table_LDR
+#define execute_STR  table_STR
+#include "../src/instruction_set.c"
+
+#define COMBINATIONS (256 * 256)
+#define TIMING_REPEATS 50
+#define SRC_REG 1
+#define OPERAND_REG 2
+
+typedef enum { PAIR_OP, IMM_OP, SHIFT_OP } OpKind;
+
+// One backend's execute_* for an op; only the member matching the kind is set
+typedef struct {
+    void (*pair)(uint8_t, uint8_t);
+    void (*imm)(uint8_t, int8_t);
+    void (*shift)(uint8_t, uint8_t);
+} AluHandler;
+
+typedef struct {
+    const char* name;
+    OpKind kind;
+    const uint16_t* table;
+    uint8_t mask;
+    AluHandler branch;
+    AluHandler tables;
+} AluOp;
+
+static const AluOp OPS[] = {
+    {"ADD",  PAIR_OP,  ALU_ADD_TABLE,  ALU_FLAGS_ADD, {branch_ADD, NULL, NULL}, {table_ADD, NULL, NULL}},
+    {"SUB",  PAIR_OP,  ALU_SUB_TABLE,  ALU_FLAGS_SUB, {branch_SUB, NULL, NULL}, {table_SUB, NULL, NULL}},
+    {"MUL",  PAIR_OP,  ALU_MUL_TABLE,  ALU_FLAGS_NZ,  {branch_MUL, NULL, NULL}, {table_MUL, NULL, NULL}},
+    {"EOR",  PAIR_OP,  ALU_EOR_TABLE,  ALU_FLAGS_NZ,  {branch_EOR, NULL, NULL}, {table_EOR, NULL, NULL}},
+    {"ANDI", IMM_OP,   ALU_ANDI_TABLE, ALU_FLAGS_NZ,  {NULL, branch_ANDI, NULL}, {NULL, table_ANDI, NULL}},
+    {"SAL",  SHIFT_OP, ALU_SAL_TABLE,  ALU_FLAGS_NZ,  {NULL, NULL, branch_SAL}, {NULL, NULL, table_SAL}},
+    {"SAR",  SHIFT_OP, ALU_SAR_TABLE,  ALU_FLAGS_NZ,  {NULL, NULL, branch_SAR}, {NULL, NULL, table_SAR}},
+};
+
+#define OP_COUNT (sizeof(OPS) / sizeof(AluOp))
+
+static double now_ns() {
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+// Expected table entry for combination i: high byte is the first operand
+// (or the immediate/shift amount), low byte the second
+static uint16_t table_entry(const AluOp* op, int i) {
+    int8_t hi = (int8_t)(i >> 8);
+    int8_t lo = (int8_t)(i & 0xFF);
+    switch (op->kind) {
+        case PAIR_OP:  return aluPairEntry(op->table, hi, lo);
+        case IMM_OP:   return aluPairEntry(op->table, hi, lo);
+        default:       return aluShiftEntry(op->table, lo, (uint8_t)hi);
+    }
+}
+
+// Loads the operands for combination i and runs one backend's execute_* function
+static void run_execute(const AluOp* op, const AluHandler* handler, int i) {
+    int8_t hi = (int8_t)(i >> 8);
+    int8_t lo = (int8_t)(i & 0xFF);
+    switch (op->kind) {
+        case PAIR_OP:
+            registers[SRC_REG] = hi;
+            registers[OPERAND_REG] = lo;
+            handler->pair(SRC_REG, OPERAND_REG);
+            break;
+        case IMM_OP:
+            registers[SRC_REG] = lo;
+            handler->imm(SRC_REG, hi);
+            break;
+        default:
+            registers[SRC_REG] = lo;
+            handler->shift(SRC_REG, (uint8_t)hi);
+            break;
+    }
+}
+
+// Initial SREG for combination i; varies so preserved bits are checked too
+static uint8_t initial_sreg(int i) {
+    return (uint8_t)(i * 0x9D);
+}
+
+// Times one backend's execute_* over every combination
+static double time_execute(const AluOp* op, const AluHandler* handler) {
+    double start = now_ns();
+    for (int rep = 0; rep < TIMING_REPEATS; rep++) {
+        for (int i = 0; i < COMBINATIONS; i++) {
+            run_execute(op, handler, i);
+        }
+    }
+    return (now_ns() - start) / ((double)COMBINATIONS * TIMING_REPEATS);
+}
+
+static void report_mismatch(int* failures, const char* what, const AluOp* op, int i,
+                            int8_t got, uint8_t gotSreg, int8_t expected, uint8_t expectedSreg) {
+    if ((*failures)++ < 10) {
+        fprintf(stderr, "Mismatch %s %s 0x%02X,0x%02X: got %d/0x%02X, expected %d/0x%02X\n",
+                what, op->name, i >> 8, i & 0xFF, got, gotSreg, expected, expectedSreg);
+    }
+}
+
+int main() {
+    int failures = 0;
+    double branch_ns[OP_COUNT];
+    double table_ns[OP_COUNT];
+
+    for (size_t k = 0; k < OP_COUNT; k++) {
+        const AluOp* op = &OPS[k];
+
+        // Exhaustive check of the tables and the table backend against the branching backend
+        for (int i = 0; i < COMBINATIONS; i++) {
+            uint8_t sreg = initial_sreg(i);
+            SREG = sreg;
+            run_execute(op, &op->branch, i);
+            int8_t expected = registers[SRC_REG];
+            uint8_t expectedSreg = SREG;
+
+            uint16_t entry = table_entry(op, i);
+            if (aluResult(entry) != expected || aluMergeFlags(sreg, entry, op->mask) != expectedSreg) {
+                report_mismatch(&failures, "table", op, i, aluResult(entry),
+                                aluMergeFlags(sreg, entry, op->mask), expected, expectedSreg);
+            }
+
+            SREG = sreg;
+            run_execute(op, &op->tables, i);
+            if (registers[SRC_REG] != expected || SREG != expectedSreg) {
+                report_mismatch(&failures, "execute", op, i, registers[SRC_REG], SREG, expected, expectedSreg);
+            }
+        }
+
+        branch_ns[k] = time_execute(op, &op->branch);
+        table_ns[k] = time_execute(op, &op->tables);
+    }
+
+    printf("Library backend: %s\n", LIBRARY_BACKEND);
+    printf("%-6s %12s %14s %14s\n", "Op", "Checked", "branch ns/op", "table ns/op");
+    for (size_t k = 0; k < OP_COUNT; k++) {
+        printf("%-6s %12d %14.2f %14.2f\n", OPS[k].name, COMBINATIONS, branch_ns[k], table_ns[k]);
+    }
+    printf("%s (%d mismatches)\n", failures ? "FAILED" : "PASSED", failures);
+    return failures ? 1 : 0;
+}
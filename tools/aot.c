@@ -0,0 +1,493 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../includes/simulator.h"
+#include "../includes/isa.h"
+
+/**
+ * Ahead-of-time translator.
+ * Assembles a program, splits it into basic blocks and emits a standalone C
+ * translation unit in which every block is straight-line code over the
+ * register file and dataMemory. BEQZ becomes a direct goto; BR goes through
+ * a dispatch switch over every instruction address, since its target is only
+ * known at run time. The generated program prints the same final state and
+ * cycle/instruction counts as `processor --quiet`, so the two can be diffed.
+ *
+ * Cycle counts use the closed form of the IF/ID/EX timing: with N executed
+ * instructions and T taken branches the pipeline needs N + 2 + 2T cycles, one
+ * less when the last executed instruction is a taken branch (its target is
+ * the HALT, so there is nothing left to drain), and 1 cycle when N is 0.
+ *
+ * The generated program takes --max-cycles N like the interpreter. The k-th
+ * instruction executes in cycle k + 2 + 2T (T taken branches before it), so
+ * each block checks on entry, and BR dispatch on every jump, that the rest of
+ * the block fits the budget. If not, a cold copy of the block runs the
+ * instructions that do fit, and the PC is set to where the fetch stage has
+ * got to by the last cycle.
+ *
+ * Usage: aot program.txt [-o out.c]
+ *        aot --image program.bin [-o out.c]   (raw little-endian 16-bit words)
+ */
+
+#define HALT_WORD 0xFFFF
+
+typedef struct {
+    uint16_t words[INSTRUCTION_MEMORY_SIZE];
+    bool leader[INSTRUCTION_MEMORY_SIZE];
+    bool labelled[INSTRUCTION_MEMORY_SIZE];   // Some goto names this address
+    bool hasBR;
+    int instructions;
+    int blocks;
+} Program;
+
+// ================== Decoding ==================
+
+static uint8_t opcodeOf(uint16_t word) { return (word >> 12) & 0x0F; }
+static uint8_t r1Of(uint16_t word) { return (word >> 6) & 0x3F; }
+static uint8_t operandOf(uint16_t word) { return word & 0x3F; }
+
+// Same sign extension as the decode stage (LDR/STR addresses stay unsigned)
+static int8_t immediateOf(uint16_t word) {
+    uint8_t imm = operandOf(word);
+    return (int8_t)((imm & 0x20) ? (imm | 0xC0) : imm);
+}
+
+static bool isInstruction(const Program* prog, uint32_t address) {
+    return address < INSTRUCTION_MEMORY_SIZE && prog->words[address] != HALT_WORD;
+}
+
+static uint16_t beqzTarget(uint16_t address, uint16_t word) {
+    return (uint16_t)(address + 1 + immediateOf(word));
+}
+
+static bool isBranch(uint16_t word) {
+    return ISA_TABLE[opcodeOf(word)].flags & ISA_BRANCH;
+}
+
+static void disassemble(uint16_t word, char* out, size_t size) {
+    uint8_t opcode = opcodeOf(word);
+    const InstructionInfo* info = &ISA_TABLE[opcode];
+    if (!info->name) {
+        snprintf(out, size, "unknown 0x%04X", word);
+    } else if (info->operand == OPERAND_REGISTER) {
+        snprintf(out, size, "%s R%d R%d", info->name, r1Of(word), operandOf(word));
+    } else if (info->operand == OPERAND_ADDRESS) {
+        snprintf(out, size, "%s R%d %d", info->name, r1Of(word), operandOf(word));
+    } else {
+        snprintf(out, size, "%s R%d %d", info->name, r1Of(word), immediateOf(word));
+    }
+}
+
+// ================== Control-Flow Graph ==================
+
+/**
+ * Marks block leaders: the entry point, every BEQZ target and every
+ * instruction that follows a branch. A block runs from its leader up to the
+ * next branch, HALT word or leader.
+ */
+static void buildBlocks(Program* prog) {
+    for (int a = 0; a < INSTRUCTION_MEMORY_SIZE; a++) {
+        if (!isInstruction(prog, a)) continue;
+        uint16_t word = prog->words[a];
+        prog->instructions++;
+        if (a == 0 || !isInstruction(prog, a - 1) || isBranch(prog->words[a - 1])) {
+            prog->leader[a] = true;
+        }
+        if (opcodeOf(word) == OP_BEQZ) {
+            uint16_t target = beqzTarget(a, word);
+            if (isInstruction(prog, target)) {
+                prog->leader[target] = true;
+                prog->labelled[target] = true;
+            }
+        } else if (opcodeOf(word) == OP_BR) {
+            prog->hasBR = true;
+        }
+    }
+    for (int a = 0; a < INSTRUCTION_MEMORY_SIZE; a++) {
+        if (prog->leader[a]) prog->blocks++;
+        // Any instruction may be a BR target
+        if (prog->hasBR && isInstruction(prog, a)) prog->labelled[a] = true;
+    }
+}
+
+static int blockEnd(const Program* prog, int start) {
+    int end = start;
+    while (!isBranch(prog->words[end]) && isInstruction(prog, end + 1) && !prog->leader[end + 1]) {
+        end++;
+    }
+    return end;
+}
+
+// ================== Emission ==================
+
+static void emitPreamble(FILE* out, const char* source, const Program* prog) {
+    fprintf(out,
+        "/* Generated by aot from %s: %d instructions in %d basic blocks. */\n"
+        "#include <stdio.h>\n"
+        "#include <stdint.h>\n"
+        "#include <stdlib.h>\n"
+        "#include <string.h>\n"
+        "\n"
+        "#define REGISTER_COUNT 64\n"
+        "#define DATA_MEMORY_SIZE 2048\n"
+        "\n"
+        "static int8_t registers[REGISTER_COUNT];\n"
+        "static uint8_t SREG = 0;\n"
+        "static uint16_t PC = 0;\n"
+        "static int8_t dataMemory[DATA_MEMORY_SIZE];\n"
+        "static uint64_t instructionCount = 0;\n"
+        "static uint64_t branchesTaken = 0;\n"
+        "static int lastTaken = 0;\n"
+        "static uint64_t budget = UINT64_MAX;   /* --max-cycles */\n"
+        "static int budgetHit = 0;\n"
+        "\n"
+        "/* True if the next n instructions all execute within the budget */\n"
+        "static inline int fits(uint64_t n) {\n"
+        "    return instructionCount + 2 * branchesTaken + n + 2 <= budget;\n"
+        "}\n"
+        "\n"
+        "/* Stops before the instruction at address, which would execute after the\n"
+        "   budget; fetch has run up to two words past it, or up to the HALT word */\n"
+        "static inline void stopAt(uint16_t address, uint16_t haltAddress) {\n"
+        "    uint64_t ahead = budget - instructionCount - 2 * branchesTaken;\n"
+        "    PC = address + ahead > haltAddress ? haltAddress : (uint16_t)(address + ahead);\n"
+        "    budgetHit = 1;\n"
+        "}\n"
+        "\n",
+        source, prog->instructions, prog->blocks);
+
+    fprintf(out, "static const uint16_t programWords[][2] = {\n");
+    for (int a = 0; a < INSTRUCTION_MEMORY_SIZE; a++) {
+        if (prog->words[a] != HALT_WORD) {
+            fprintf(out, "    {%d, %u},\n", a, prog->words[a]);
+        }
+    }
+    fprintf(out, "    {0xFFFF, 0}\n};\n\n");
+
+    // ALU helpers with the interpreter's exact flag semantics (C=4 V=3 N=2 S=1 Z=0)
+    fputs(
+        "static inline void setNZ(int n, int z) {\n"
+        "    SREG = (uint8_t)((SREG & ~0x05) | (n << 2) | z);\n"
+        "}\n"
+        "\n"
+        "static inline void opADD(int d, int s) {\n"
+        "    int8_t a = registers[d], b = registers[s];\n"
+        "    int8_t r = (int8_t)(a + b);\n"
+        "    int c = (uint8_t)a + (uint8_t)b > 0xFF;\n"
+        "    int v = (a > 0 && b > 0 && r < 0) || (a < 0 && b < 0 && r >= 0);\n"
+        "    int n = r < 0;\n"
+        "    registers[d] = r;\n"
+        "    SREG = (uint8_t)((SREG & ~0x1F) | (c << 4) | (v << 3) | (n << 2) | ((n ^ v) << 1) | (r == 0));\n"
+        "}\n"
+        "\n"
+        "static inline void opSUB(int d, int s) {\n"
+        "    int8_t a = registers[d], b = registers[s];\n"
+        "    int8_t r = (int8_t)(a - b);\n"
+        "    int v = (a >= 0 && b < 0 && r < 0) || (a < 0 && b > 0 && r >= 0);\n"
+        "    int n = r < 0;\n"
+        "    registers[d] = r;\n"
+        "    SREG = (uint8_t)((SREG & ~0x0F) | (v << 3) | (n << 2) | ((n ^ v) << 1) | (r == 0));\n"
+        "}\n"
+        "\n"
+        "static inline void opMUL(int d, int s) {\n"
+        "    int p = registers[d] * registers[s];\n"
+        "    registers[d] = (int8_t)p;\n"
+        "    setNZ(p < 0, p == 0);\n"
+        "}\n"
+        "\n"
+        "static inline void opEOR(int d, int s) {\n"
+        "    int8_t r = registers[d] ^ registers[s];\n"
+        "    registers[d] = r;\n"
+        "    setNZ(r < 0, r == 0);\n"
+        "}\n"
+        "\n"
+        "static inline void opANDI(int d, int8_t imm) {\n"
+        "    int8_t r = registers[d] & imm;\n"
+        "    registers[d] = r;\n"
+        "    setNZ(r < 0, r == 0);\n"
+        "}\n"
+        "\n"
+        "static inline void opSAL(int d, uint8_t amount) {\n"
+        "    int8_t r = amount >= 8 ? 0 : (int8_t)((uint8_t)registers[d] << amount);\n"
+        "    registers[d] = r;\n"
+        "    setNZ(r < 0, r == 0);\n"
+        "}\n"
+        "\n"
+        "static inline void opSAR(int d, uint8_t amount) {\n"
+        "    int8_t a = registers[d];\n"
+        "    int8_t r = amount >= 8 ? (a < 0 ? -1 : 0) : (int8_t)(a >> amount);\n"
+        "    registers[d] = r;\n"
+        "    setNZ(r < 0, r == 0);\n"
+        "}\n"
+        "\n", out);
+}
+
+// Emits the jump taken when control reaches `target`
+static void emitJump(FILE* out, const Program* prog, uint32_t target, const char* indent) {
+    if (isInstruction(prog, target)) {
+        fprintf(out, "%sgoto I%u;\n", indent, target);
+    } else {
+        fprintf(out, "%sPC = %u;\n%sgoto halt;\n", indent, target & 0xFFFF, indent);
+    }
+}
+
+// Fields of the instruction being emitted
+typedef struct {
+    const Program* prog;
+    uint16_t address;
+    uint16_t word;
+    uint8_t r1;
+    uint8_t r2;            // Operand field as a source register or data address
+    int8_t imm;            // Operand field sign-extended
+} EmitContext;
+
+typedef void (*Emitter)(FILE* out, const EmitContext* c);
+
+// One emitter per instruction, emit<NAME>; EMITTERS is expanded from
+// ISA_INSTRUCTIONS, so an instruction without an emitter does not compile
+static void emitADD(FILE* out, const EmitContext* c) { fprintf(out, "    opADD(%d, %d);\n", c->r1, c->r2); }
+static void emitSUB(FILE* out, const EmitContext* c) { fprintf(out, "    opSUB(%d, %d);\n", c->r1, c->r2); }
+static void emitMUL(FILE* out, const EmitContext* c) { fprintf(out, "    opMUL(%d, %d);\n", c->r1, c->r2); }
+static void emitMOVI(FILE* out, const EmitContext* c) { fprintf(out, "    registers[%d] = %d;\n", c->r1, c->imm); }
+static void emitANDI(FILE* out, const EmitContext* c) { fprintf(out, "    opANDI(%d, %d);\n", c->r1, c->imm); }
+static void emitEOR(FILE* out, const EmitContext* c) { fprintf(out, "    opEOR(%d, %d);\n", c->r1, c->r2); }
+static void emitSAL(FILE* out, const EmitContext* c) { fprintf(out, "    opSAL(%d, %u);\n", c->r1, (uint8_t)c->imm); }
+static void emitSAR(FILE* out, const EmitContext* c) { fprintf(out, "    opSAR(%d, %u);\n", c->r1, (uint8_t)c->imm); }
+static void emitLDR(FILE* out, const EmitContext* c) { fprintf(out, "    registers[%d] = dataMemory[%d];\n", c->r1, c->r2); }
+static void emitSTR(FILE* out, const EmitContext* c) { fprintf(out, "    dataMemory[%d] = registers[%d];\n", c->r2, c->r1); }
+
+static void emitBEQZ(FILE* out, const EmitContext* c) {
+    fprintf(out, "    if (registers[%d] == 0) {\n", c->r1);
+    fprintf(out, "        branchesTaken++;\n        lastTaken = 1;\n");
+    emitJump(out, c->prog, beqzTarget(c->address, c->word), "        ");
+    fprintf(out, "    }\n");
+}
+
+static void emitBR(FILE* out, const EmitContext* c) {
+    fprintf(out, "    target = (uint16_t)(registers[%d] * 256 | registers[%d]);\n", c->r1, c->r2);
+    fprintf(out, "    branchesTaken++;\n    lastTaken = 1;\n    goto dispatch;\n");
+}
+
+#define EMITTER_ENTRY(name, opcode, operand, flags, unit) [opcode] = emit##name,
+static const Emitter EMITTERS[OPCODE_COUNT] = {
+    ISA_INSTRUCTIONS(EMITTER_ENTRY)
+};
+
+static void emitInstruction(FILE* out, const Program* prog, int address) {
+    uint16_t word = prog->words[address];
+    EmitContext context = {prog, (uint16_t)address, word, r1Of(word), operandOf(word), immediateOf(word)};
+    char text[32];
+
+    disassemble(word, text, sizeof(text));
+    fprintf(out, "    /* %d: %s */\n", address, text);
+    fprintf(out, "    instructionCount++;\n");
+
+    Emitter emit = EMITTERS[opcodeOf(word)];
+    if (emit) {
+        emit(out, &context);
+    } else {
+        fprintf(out, "    /* no effect */\n");
+    }
+}
+
+// First address at or after address that fetch stops on
+static int haltAddressFrom(const Program* prog, int address) {
+    while (isInstruction(prog, address)) address++;
+    return address;
+}
+
+/**
+ * Emits the cold copy of a block that runs while the budget lasts: every
+ * instruction but the last, each behind a check. It is entered only when the
+ * block does not fit, so the last instruction never runs here. T<address>
+ * labels are dispatch entry points for BR.
+ */
+static void emitBudgetTail(FILE* out, const Program* prog, int start, int end) {
+    int haltAddress = haltAddressFrom(prog, start);
+    fprintf(out, "\n    /* ---- block %d..%d, out of budget ---- */\n", start, end);
+    for (int a = start; a <= end; a++) {
+        if (a == start || prog->hasBR) {
+            fprintf(out, "T%d:\n", a);
+        }
+        if (a == end) {
+            fprintf(out, "    stopAt(%d, %d);\n    goto halt;\n", a, haltAddress);
+            break;
+        }
+        fprintf(out, "    if (!fits(1)) {\n        stopAt(%d, %d);\n        goto halt;\n    }\n",
+                a, haltAddress);
+        emitInstruction(out, prog, a);
+        fprintf(out, "    lastTaken = 0;\n");
+    }
+}
+
+static void emitRun(FILE* out, const Program* prog) {
+    fprintf(out, "static void run(void) {\n");
+    if (prog->hasBR) {
+        fprintf(out, "    uint16_t target;\n");
+    }
+    if (!isInstruction(prog, 0)) {
+        fprintf(out, "    PC = 0;\n    goto halt;\n");
+    }
+
+    for (int start = 0; start < INSTRUCTION_MEMORY_SIZE; start++) {
+        if (!prog->leader[start]) continue;
+        int end = blockEnd(prog, start);
+
+        fprintf(out, "\n    /* ---- block %d..%d ---- */\n", start, end);
+        for (int a = start; a <= end; a++) {
+            if (prog->labelled[a]) {
+                fprintf(out, "I%d:\n", a);
+            }
+            if (a == start) {
+                fprintf(out, "    if (!fits(%d)) goto T%d;\n", end - start + 1, start);
+            }
+            emitInstruction(out, prog, a);
+            // The host compiler folds these stores into one per block
+            if (opcodeOf(prog->words[a]) != OP_BR) {
+                fprintf(out, "    lastTaken = 0;\n");
+            }
+        }
+        // Blocks are emitted in address order, so only falling onto a HALT
+        // word or off the end of memory needs an explicit jump
+        if (opcodeOf(prog->words[end]) != OP_BR && !isInstruction(prog, (uint32_t)end + 1)) {
+            emitJump(out, prog, (uint32_t)end + 1, "    ");
+        }
+    }
+
+    if (prog->hasBR) {
+        // A target inside a block skips its entry check, so test the rest here
+        fprintf(out, "\ndispatch:\n    switch (target) {\n");
+        int end = 0;
+        for (int a = 0; a < INSTRUCTION_MEMORY_SIZE; a++) {
+            if (prog->leader[a]) end = blockEnd(prog, a);
+            if (isInstruction(prog, a)) {
+                fprintf(out, "        case %d: if (fits(%d)) goto I%d; goto T%d;\n", a, end - a + 1, a, a);
+            }
+        }
+        fprintf(out, "        default: PC = target; goto halt;\n    }\n");
+    }
+
+    for (int start = 0; start < INSTRUCTION_MEMORY_SIZE; start++) {
+        if (prog->leader[start]) {
+            emitBudgetTail(out, prog, start, blockEnd(prog, start));
+        }
+    }
+    fprintf(out, "\nhalt:\n    return;\n}\n\n");
+}
+
+static void emitMain(FILE* out) {
+    fputs(
+        "int main(int argc, char* argv[]) {\n"
+        "    for (int i = 1; i < argc; i++) {\n"
+        "        if (strcmp(argv[i], \"--max-cycles\") == 0 && i + 1 < argc) {\n"
+        "            budget = strtoull(argv[++i], NULL, 10);\n"
+        "            if (budget == 0) budget = UINT64_MAX;\n"
+        "        } else {\n"
+        "            printf(\"Usage: %s [--max-cycles N]\\n\", argv[0]);\n"
+        "            return 1;\n"
+        "        }\n"
+        "    }\n"
+        "\n"
+        "    run();\n"
+        "    uint64_t cycles = instructionCount == 0 ? 1 :\n"
+        "        instructionCount + 2 + 2 * branchesTaken - (uint64_t)lastTaken;\n"
+        "    /* Out of budget while draining: every instruction ran, PC is at the HALT */\n"
+        "    if (budgetHit || cycles > budget) {\n"
+        "        cycles = budget;\n"
+        "        printf(\"\\nSIMULATION STOPPED: MAXIMUM CYCLES (%llu)\\n\", (unsigned long long)budget);\n"
+        "    }\n"
+        "\n"
+        "    printf(\"\\n=== Final State ===\\n\");\n"
+        "    printf(\"===== Register Dump =====\\n\");\n"
+        "    for (int i = 0; i < REGISTER_COUNT; ++i) {\n"
+        "        printf(\"R%d: %d (0x%02X)\\n\", i, registers[i], (uint8_t)registers[i]);\n"
+        "    }\n"
+        "    printf(\"\\n===== SREG =====\\n\");\n"
+        "    printf(\"SREG:%d (0x%02X) (C=%d, V=%d, N=%d, S=%d, Z=%d)\\n\", SREG, SREG,\n"
+        "           (SREG >> 4) & 1, (SREG >> 3) & 1, (SREG >> 2) & 1, (SREG >> 1) & 1, SREG & 1);\n"
+        "    printf(\"\\n===== Program Counter =====\\n\");\n"
+        "    printf(\"PC: %d (0x%04X)\\n\\n\", PC, PC);\n"
+        "    printf(\"===== Instruction Memory Dump =====\\n\");\n"
+        "    for (int i = 0; programWords[i][0] != 0xFFFF; ++i) {\n"
+        "        printf(\"Addr [%d] : %d (0x%04X)\\n\", programWords[i][0], programWords[i][1], programWords[i][1]);\n"
+        "    }\n"
+        "    printf(\"\\n\");\n"
+        "    printf(\"\\n===== Data Memory Dump =====\\n\");\n"
+        "    for (int i = 0; i < DATA_MEMORY_SIZE; ++i) {\n"
+        "        if (dataMemory[i] != 0) {\n"
+        "            printf(\"Addr [%d] : %d (0x%02X)\\n\", i, dataMemory[i], (uint8_t)dataMemory[i]);\n"
+        "        }\n"
+        "    }\n"
+        "    printf(\"\\n\");\n"
+        "    printf(\"Cycles: %llu | Instructions: %llu\\n\",\n"
+        "           (unsigned long long)cycles, (unsigned long long)instructionCount);\n"
+        "    return 0;\n"
+        "}\n", out);
+}
+
+// ================== Main ==================
+
+static int loadImageFile(Simulator* sim, const char* filename) {
+    FILE* file = fopen(filename, "rb");
+    if (!file) return -1;
+    uint16_t words[INSTRUCTION_MEMORY_SIZE];
+    size_t count = fread(words, sizeof(uint16_t), INSTRUCTION_MEMORY_SIZE, file);
+    fclose(file);
+    return simLoadImage(sim, words, count);
+}
+
+int main(int argc, char* argv[]) {
+    const char* input = NULL;
+    const char* output = NULL;
+    bool image = false;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+            output = argv[++i];
+        } else if (strcmp(argv[i], "--image") == 0) {
+            image = true;
+        } else if (argv[i][0] != '-' && !input) {
+            input = argv[i];
+        } else {
+            input = NULL;
+            break;
+        }
+    }
+    if (!input) {
+        printf("Usage: %s program.txt [-o out.c]\n", argv[0]);
+        printf("       %s --image program.bin [-o out.c]\n", argv[0]);
+        return 1;
+    }
+
+    Simulator* sim = simCreate(NULL);
+    if (!sim) {
+        printf("Error: Could not create simulator\n");
+        return 1;
+    }
+    int loaded = image ? loadImageFile(sim, input) : simLoadFile(sim, input);
+    if (loaded < 0) {
+        printf("Error: Failed to load program %s\n", input);
+        simDestroy(sim);
+        return 1;
+    }
+
+    static Program prog;
+    simReadInstructionMemory(sim, 0, prog.words, INSTRUCTION_MEMORY_SIZE);
+    simDestroy(sim);
+    buildBlocks(&prog);
+
+    FILE* out = output ? fopen(output, "w") : stdout;
+    if (!out) {
+        printf("Error: Could not open file %s\n", output);
+        return 1;
+    }
+    emitPreamble(out, input, &prog);
+    emitRun(out, &prog);
+    emitMain(out);
+    if (output) {
+        fclose(out);
+        fprintf(stderr, "[AOT] %s: %d instructions, %d basic blocks -> %s\n",
+                input, prog.instructions, prog.blocks, output);
+    }
+    return 0;
+}
@@ -0,0 +1,431 @@
+#include <stdio.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "../includes/pipeline.h"
+#include "../includes/block_cache.h"
+#include "../includes/estimator.h"
+#include "../includes/trace.h"
+
+/**
+ * Coverage-guided differential fuzzer.
+ * Generates and mutates small programs together with their initial register
+ * and data-memory contents, runs each case on the cycle-by-cycle pipeline
+ * and on the block-translation engine, and reports any difference in final
+ * state, PC or cycle/instruction counts. Every case runs with branches
+ * resolved in EX and again in ID. On halting runs the pipeline's cycle count
+ * is also checked against the closed-form IF/ID/EX timing: N + 2 + 2T with
+ * branches in EX and N + 2 + T + I with branches in ID, where I counts
+ * branches reading a register written by the instruction right before them;
+ * both minus one if the last instruction was a taken branch. The analytic
+ * estimator (estimator.h) must reach the same cycle and instruction counts.
+ *
+ * Coverage is kept in two byte maps: guest edges (previous PC -> PC, from
+ * the onRetire event) and, when the simulator sources are built with
+ * -fsanitize-coverage=trace-pc (`make fuzz-cov`), host edges between
+ * simulator basic blocks. A case that sets a new byte joins the corpus.
+ *
+ * Between cases the machine is not re-initialized: only the state a case can
+ * touch (registers, the first 64 data bytes, the program words and the
+ * pipeline latches/counters) is restored from a pristine copy.
+ *
+ * Usage: fuzz [--seconds N] [--seed S] [--cycles N] [--out DIR]
+ *        fuzz --replay case.bin
+ */
+
+#define MAX_PROGRAM 48             // Words per generated program
+#define FUZZ_DATA_BYTES 64         // LDR/STR reach addresses 0-63 only
+#define MAX_CORPUS 4096
+#define COVERAGE_MAP_SIZE (1 << 16)
+#define DEFAULT_CYCLES 64          // Enough for any loop-free case; loops stop here
+
+typedef struct {
+    uint16_t words[MAX_PROGRAM];
+    uint8_t length;
+    int8_t registers[REGISTER_COUNT];
+    int8_t data[FUZZ_DATA_BYTES];
+} FuzzCase;
+
+typedef struct {
+    int8_t registers[REGISTER_COUNT];
+    int8_t data[FUZZ_DATA_BYTES];
+    uint8_t sreg;
+    uint16_t pc;
+    uint64_t cycles;
+    uint64_t instructions;
+    bool halted;
+} Outcome;
+
+// ================== Coverage ==================
+
+static uint8_t guestMap[COVERAGE_MAP_SIZE];
+static uint8_t hostMap[COVERAGE_MAP_SIZE];
+static uint32_t guestEdges = 0;
+static uint32_t hostEdges = 0;
+static bool newCoverage = false;
+static uintptr_t previousHostPC = 0;
+
+// Called by every instrumented simulator basic block (-fsanitize-coverage=trace-pc)
+void __sanitizer_cov_trace_pc(void) {
+    uintptr_t pc = (uintptr_t)__builtin_return_address(0);
+    uint32_t index = (uint32_t)((pc ^ (previousHostPC >> 1)) & (COVERAGE_MAP_SIZE - 1));
+    previousHostPC = pc;
+    if (!hostMap[index]) {
+        hostMap[index] = 1;
+        hostEdges++;
+        newCoverage = true;
+    }
+}
+
+// Retirement statistics of the pipeline run, for coverage and the timing check
+typedef struct {
+    uint16_t previousPC;
+    uint8_t previousDest;
+    uint64_t taken;
+    uint64_t interlocks;
+    bool lastTaken;
+} RetireStats;
+
+static void onRetire(void* user, const RetireRecord* record) {
+    RetireStats* stats = user;
+    uint32_t index = ((uint32_t)stats->previousPC * 1021u ^ record->pc) & (COVERAGE_MAP_SIZE - 1);
+    stats->previousPC = record->pc;
+    if (!guestMap[index]) {
+        guestMap[index] = 1;
+        guestEdges++;
+        newCoverage = true;
+    }
+    stats->lastTaken = (record->flags & RETIRE_TAKEN) != 0;
+    stats->taken += stats->lastTaken;
+    if ((ISA_TABLE[record->opcode & 0x0F].flags & ISA_BRANCH) && stats->previousDest != RETIRE_NO_REG &&
+        (stats->previousDest == record->src1 || stats->previousDest == record->src2)) {
+        stats->interlocks++;
+    }
+    stats->previousDest = record->dest;
+}
+
+// ================== Random Cases ==================
+
+static uint64_t rngState = 0x9E3779B97F4A7C15ull;
+
+static uint32_t nextRandom() {
+    rngState ^= rngState << 13;
+    rngState ^= rngState >> 7;
+    rngState ^= rngState << 17;
+    return (uint32_t)(rngState >> 16);
+}
+
+static uint32_t randomBelow(uint32_t bound) {
+    return nextRandom() % bound;
+}
+
+// Mostly valid opcodes and low registers, so cases do something interesting
+static uint16_t randomInstruction() {
+    uint16_t opcode = randomBelow(16) < 15 ? (uint16_t)randomBelow(12) : (uint16_t)(12 + randomBelow(4));
+    uint16_t r1 = randomBelow(4) ? (uint16_t)randomBelow(8) : (uint16_t)randomBelow(64);
+    uint16_t operand = randomBelow(2) ? (uint16_t)randomBelow(8) : (uint16_t)randomBelow(64);
+    return (uint16_t)(opcode << 12 | r1 << 6 | operand);
+}
+
+// Small values make BR targets (R1 << 8 | R2) land inside the program
+static int8_t randomValue(uint8_t length) {
+    return randomBelow(2) ? (int8_t)randomBelow(length + 2u) : (int8_t)nextRandom();
+}
+
+static void randomCase(FuzzCase* c) {
+    memset(c, 0, sizeof(*c));
+    c->length = (uint8_t)(1 + randomBelow(16));
+    for (int i = 0; i < c->length; i++) {
+        c->words[i] = randomInstruction();
+    }
+    for (int i = 0; i < 8; i++) {
+        c->registers[i] = randomValue(c->length);
+    }
+}
+
+static void mutateCase(FuzzCase* c, const FuzzCase* other) {
+    int count = 1 + (int)randomBelow(4);
+    for (int m = 0; m < count; m++) {
+        uint32_t at = c->length ? randomBelow(c->length) : 0;
+        switch (randomBelow(8)) {
+            case 0:
+                if (c->length) c->words[at] = randomInstruction();
+                break;
+            case 1:
+                if (c->length) c->words[at] ^= (uint16_t)(1u << randomBelow(16));
+                break;
+            case 2:
+                if (c->length < MAX_PROGRAM) {
+                    memmove(&c->words[at + 1], &c->words[at], (c->length - at) * sizeof(uint16_t));
+                    c->words[at] = randomInstruction();
+                    c->length++;
+                }
+                break;
+            case 3:
+                if (c->length > 1) {
+                    memmove(&c->words[at], &c->words[at + 1], (c->length - at - 1) * sizeof(uint16_t));
+                    c->length--;
+                }
+                break;
+            case 4:
+                c->registers[randomBelow(8)] = randomValue(c->length);
+                break;
+            case 5:
+                c->data[randomBelow(FUZZ_DATA_BYTES)] = (int8_t)nextRandom();
+                break;
+            case 6:
+                if (c->length) c->words[at] = (uint16_t)((c->words[at] & 0xFFC0) | randomBelow(64));
+                break;
+            default:
+                // Splice: keep our head, take the other case's tail
+                if (other->length > 1) {
+                    uint32_t from = randomBelow(other->length);
+                    uint32_t room = MAX_PROGRAM - at;
+                    uint32_t take = other->length - from < room ? other->length - from : room;
+                    memcpy(&c->words[at], &other->words[from], take * sizeof(uint16_t));
+                    c->length = (uint8_t)(at + take);
+                }
+                break;
+        }
+    }
+    if (c->length == 0) {
+        c->words[0] = randomInstruction();
+        c->length = 1;
+    }
+}
+
+// ================== Execution ==================
+
+static PipelineSnapshot pristinePipeline;
+static uint8_t loadedLength = 0;
+
+/**
+ * Puts the case into the resident machine, restoring only what a previous
+ * case could have changed.
+ */
+static void loadCase(const FuzzCase* c) {
+    memcpy(registers, c->registers, sizeof(registers));
+    SREG = 0;
+    PC = 0;
+    restorePipeline(&pristinePipeline);
+    memcpy(dataMemory, c->data, FUZZ_DATA_BYTES);
+
+    int span = (c->length > loadedLength ? c->length : loadedLength) + 1;
+    for (int a = 0; a < span && a < INSTRUCTION_MEMORY_SIZE; a++) {
+        uint16_t word = a < c->length ? c->words[a] : 0xFFFF;
+        if (instructionMemory[a] != word) {
+            instructionMemory[a] = word;
+            invalidateBlocks((uint16_t)a);
+        }
+    }
+    loadedLength = c->length;
+}
+
+static void captureOutcome(Outcome* out) {
+    memset(out, 0, sizeof(*out));   // Padding takes part in the comparison
+    memcpy(out->registers, registers, sizeof(out->registers));
+    memcpy(out->data, dataMemory, sizeof(out->data));
+    out->sreg = SREG;
+    out->pc = PC;
+    out->cycles = getCycleCount();
+    out->instructions = getInstructionCount();
+    out->halted = isPipelineDrained();
+}
+
+static void runPipelineEngine(const FuzzCase* c, uint64_t cycles, Outcome* out, RetireStats* stats) {
+    SimCallbacks callbacks = {0};
+    callbacks.onRetire = onRetire;
+    callbacks.user = stats;
+    memset(stats, 0, sizeof(*stats));
+    stats->previousDest = RETIRE_NO_REG;
+    setTraceCallbacks(&callbacks);
+
+    loadCase(c);
+    while (!isPipelineDrained() && getCycleCount() < cycles) {
+        pipelineCycle();
+    }
+    captureOutcome(out);
+}
+
+static void runBlockEngine(const FuzzCase* c, uint64_t cycles, Outcome* out) {
+    setTraceCallbacks(NULL);
+    loadCase(c);
+    runBlocks(cycles);
+    while (!isPipelineDrained() && getCycleCount() < cycles) {
+        pipelineCycle();
+    }
+    captureOutcome(out);
+}
+
+static bool runEstimator(const FuzzCase* c, uint64_t cycles, CycleEstimate* estimate) {
+    setTraceCallbacks(NULL);
+    loadCase(c);
+    return estimateCycles(cycles, estimate);
+}
+
+/**
+ * Runs one case on both engines, with branches resolved in EX and then in ID.
+ * @return: NULL if everything agrees, otherwise what went wrong (pipe and
+ *          blocks then hold the failing run).
+ */
+static const char* checkCase(const FuzzCase* c, uint64_t cycles, Outcome* pipe, Outcome* blocks) {
+    for (int inDecode = 0; inDecode <= 1; inDecode++) {
+        RetireStats stats;
+        setBranchInDecode(inDecode);
+        runPipelineEngine(c, cycles, pipe, &stats);
+        runBlockEngine(c, cycles, blocks);
+
+        if (memcmp(pipe, blocks, offsetof(Outcome, halted)) != 0 || pipe->halted != blocks->halted) {
+            return inDecode ? "pipeline and block engines disagree (branches in ID)" :
+                              "pipeline and block engines disagree";
+        }
+        if (pipe->halted) {
+            uint64_t expected = pipe->instructions == 0 ? 1 :
+                pipe->instructions + 2 + (inDecode ? stats.taken + stats.interlocks : 2 * stats.taken) -
+                (stats.lastTaken ? 1 : 0);
+            if (pipe->cycles != expected) {
+                return inDecode ? "cycle count does not match the IF/ID/EX timing (branches in ID)" :
+                                  "cycle count does not match the IF/ID/EX timing";
+            }
+            CycleEstimate estimate;
+            if (!runEstimator(c, cycles, &estimate) || !estimate.halted ||
+                estimate.cycles != pipe->cycles || estimate.instructions != pipe->instructions) {
+                return inDecode ? "analytic estimate does not match the pipeline (branches in ID)" :
+                                  "analytic estimate does not match the pipeline";
+            }
+        }
+    }
+    return NULL;
+}
+
+// ================== Reporting ==================
+
+static void printCase(const FuzzCase* c) {
+    printf("Program (%d words):\n", c->length);
+    for (int i = 0; i < c->length; i++) {
+        printf("  [%d] 0x%04X  op %d R%d %d\n", i, c->words[i], c->words[i] >> 12,
+               (c->words[i] >> 6) & 0x3F, c->words[i] & 0x3F);
+    }
+    printf("Initial registers:");
+    for (int r = 0; r < REGISTER_COUNT; r++) {
+        if (c->registers[r]) printf(" R%d=%d", r, c->registers[r]);
+    }
+    printf("\n");
+}
+
+static void printOutcome(const char* engine, const Outcome* o) {
+    printf("%-9s %s PC=%d SREG=0x%02X cycles=%llu instructions=%llu regs:", engine,
+           o->halted ? "halted " : "stopped", o->pc, o->sreg,
+           (unsigned long long)o->cycles, (unsigned long long)o->instructions);
+    for (int r = 0; r < REGISTER_COUNT; r++) {
+        if (o->registers[r]) printf(" R%d=%d", r, o->registers[r]);
+    }
+    printf("\n");
+}
+
+static double nowSeconds() {
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+// ================== Main ==================
+
+int main(int argc, char* argv[]) {
+    double seconds = 10;
+    uint64_t cycles = DEFAULT_CYCLES;
+    const char* outDir = ".";
+    const char* replayFile = NULL;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--seconds") == 0 && i + 1 < argc) {
+            seconds = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            rngState = strtoull(argv[++i], NULL, 10) * 0x9E3779B97F4A7C15ull | 1;
+        } else if (strcmp(argv[i], "--cycles") == 0 && i + 1 < argc) {
+            cycles = strtoull(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--out") == 0 && i + 1 < argc) {
+            outDir = argv[++i];
+        } else if (strcmp(argv[i], "--replay") == 0 && i + 1 < argc) {
+            replayFile = argv[++i];
+        } else {
+            printf("Usage: %s [--seconds N] [--seed S] [--cycles N] [--out DIR]\n", argv[0]);
+            printf("       %s --replay case.bin\n", argv[0]);
+            return 1;
+        }
+    }
+
+    // One full initialization; every case after this is a partial restore
+    initMemory();
+    initRegisters();
+    initPipeline();
+    savePipeline(&pristinePipeline);
+
+    static FuzzCase current;
+    Outcome pipe, blocks;
+
+    if (replayFile) {
+        FILE* file = fopen(replayFile, "rb");
+        if (!file || fread(&current, sizeof(current), 1, file) != 1) {
+            printf("Error: Could not read case %s\n", replayFile);
+            return 1;
+        }
+        fclose(file);
+        const char* problem = checkCase(&current, cycles, &pipe, &blocks);
+        printCase(&current);
+        printOutcome("pipeline", &pipe);
+        printOutcome("blocks", &blocks);
+        printf("%s\n", problem ? problem : "OK");
+        return problem ? 2 : 0;
+    }
+
+    static FuzzCase corpus[MAX_CORPUS];
+    int corpusSize = 0;
+    uint64_t executions = 0;
+    int failures = 0;
+    double start = nowSeconds();
+    double nextReport = start + 1;
+
+    while (true) {
+        if (corpusSize == 0 || randomBelow(16) == 0) {
+            randomCase(&current);
+        } else {
+            current = corpus[randomBelow(corpusSize)];
+            mutateCase(&current, &corpus[randomBelow(corpusSize)]);
+        }
+
+        newCoverage = false;
+        const char* problem = checkCase(&current, cycles, &pipe, &blocks);
+        executions++;
+
+        if (problem) {
+            char path[512];
+            snprintf(path, sizeof(path), "%s/fuzz-failure-%d.bin", outDir, failures++);
+            FILE* file = fopen(path, "wb");
+            if (file) {
+                fwrite(&current, sizeof(current), 1, file);
+                fclose(file);
+            }
+            printf("\n[FUZZ] %s (saved to %s)\n", problem, path);
+            printCase(&current);
+            printOutcome("pipeline", &pipe);
+            printOutcome("blocks", &blocks);
+        } else if (newCoverage && corpusSize < MAX_CORPUS) {
+            corpus[corpusSize++] = current;
+        }
+
+        if ((executions & 1023) == 0) {
+            double now = nowSeconds();
+            if (now >= nextReport || now - start >= seconds) {
+                printf("[FUZZ] %.0f s: %llu execs (%.0f/s), corpus %d, guest edges %u, host edges %u, failures %d\n",
+                       now - start, (unsigned long long)executions, executions / (now - start),
+                       corpusSize, guestEdges, hostEdges, failures);
+                fflush(stdout);
+                nextReport = now + 1;
+            }
+            if (now - start >= seconds) break;
+        }
+    }
+    return failures ? 2 : 0;
+}
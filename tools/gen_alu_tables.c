@@ -0,0 +1,108 @@
+#include <stdio.h>
+#include <stdint.h>
+#include "../includes/registers.h"
+
+/**
+ * Generates src/alu_tables.inc, the precomputed result+flag tables used by
+ * the table-driven ALU backend (see includes/alu_tables.h).
+ *
+ * Every entry packs the 8-bit result in bits 0-7 and the SREG flag bits the
+ * operation produces in bits 8-15. The formulas below mirror execute_* in
+ * src/instruction_set.c exactly, including its quirks (MUL takes N/Z from the
+ * 16-bit product, SUB leaves C alone, logic ops leave V/S alone).
+ *
+ * Usage: gen_alu_tables > src/alu_tables.inc
+ */
+
+#define BIT(flag) (1 << (flag))
+
+static uint16_t pack(int8_t result, uint8_t flags) {
+    return (uint16_t)((uint8_t)result | (flags << 8));
+}
+
+static uint8_t nz_flags(int result) {
+    uint8_t flags = 0;
+    if (result < 0) flags |= BIT(NEGATIVE_FLAG);
+    if (result == 0) flags |= BIT(ZERO_FLAG);
+    return flags;
+}
+
+static uint16_t entry_ADD(int8_t a, int8_t b) {
+    int8_t result = (int8_t)(a + b);
+    uint8_t flags = nz_flags(result);
+    if ((uint16_t)(uint8_t)a + (uint16_t)(uint8_t)b > 0xFF) flags |= BIT(CARRY_FLAG);
+    if ((a > 0 && b > 0 && result < 0) || (a < 0 && b < 0 && result >= 0)) flags |= BIT(OVERFLOW_FLAG);
+    if (((flags >> NEGATIVE_FLAG) ^ (flags >> OVERFLOW_FLAG)) & 1) flags |= BIT(SIGN_FLAG);
+    return pack(result, flags);
+}
+
+static uint16_t entry_SUB(int8_t a, int8_t b) {
+    int8_t result = (int8_t)(a - b);
+    uint8_t flags = nz_flags(result);
+    if ((a >= 0 && b < 0 && result < 0) || (a < 0 && b > 0 && result >= 0)) flags |= BIT(OVERFLOW_FLAG);
+    if (((flags >> NEGATIVE_FLAG) ^ (flags >> OVERFLOW_FLAG)) & 1) flags |= BIT(SIGN_FLAG);
+    return pack(result, flags);
+}
+
+static uint16_t entry_MUL(int8_t a, int8_t b) {
+    int16_t result = (int16_t)a * (int16_t)b;
+    return pack((int8_t)result, nz_flags(result));
+}
+
+static uint16_t entry_EOR(int8_t a, int8_t b) {
+    int8_t result = a ^ b;
+    return pack(result, nz_flags(result));
+}
+
+static uint16_t entry_ANDI(int8_t a, int8_t imm) {
+    int8_t result = a & imm;
+    return pack(result, nz_flags(result));
+}
+
+static uint16_t entry_SAL(int8_t a, uint8_t imm) {
+    int8_t result = (imm >= 8) ? 0 : (int8_t)(a << imm);
+    return pack(result, nz_flags(result));
+}
+
+static uint16_t entry_SAR(int8_t a, uint8_t imm) {
+    int8_t result = (imm >= 8) ? ((a < 0) ? -1 : 0) : (int8_t)(a >> imm);
+    return pack(result, nz_flags(result));
+}
+
+// Emits one table; rows are indexed by the first operand byte, columns by the second
+static void emit_pair_table(const char* name, uint16_t (*entry)(int8_t, int8_t)) {
+    printf("const uint16_t %s[256 * 256] = {\n", name);
+    for (int i = 0; i < 256 * 256; i++) {
+        if (i % 16 == 0) printf("   ");
+        printf(" 0x%04X,", entry((int8_t)(i >> 8), (int8_t)(i & 0xFF)));
+        if (i % 16 == 15) printf("\n");
+    }
+    printf("};\n\n");
+}
+
+// Shift tables are indexed [min(imm, 8)][a]; every amount >= 8 behaves the same
+static void emit_shift_table(const char* name, uint16_t (*entry)(int8_t, uint8_t)) {
+    printf("const uint16_t %s[ALU_SHIFT_LIMIT * 256] = {\n", name);
+    for (int i = 0; i < 9 * 256; i++) {
+        if (i % 16 == 0) printf("   ");
+        printf(" 0x%04X,", entry((int8_t)(i & 0xFF), (uint8_t)(i >> 8)));
+        if (i % 16 == 15) printf("\n");
+    }
+    printf("};\n\n");
+}
+
+static uint16_t entry_ANDI_imm_major(int8_t imm, int8_t a) {
+    return entry_ANDI(a, imm);
+}
+
+int main() {
+    printf("// Generated by tools/gen_alu_tables.c -- do not edit by hand.\n\n");
+    emit_pair_table("ALU_ADD_TABLE", entry_ADD);
+    emit_pair_table("ALU_SUB_TABLE", entry_SUB);
+    emit_pair_table("ALU_MUL_TABLE", entry_MUL);
+    emit_pair_table("ALU_EOR_TABLE", entry_EOR);
+    emit_pair_table("ALU_ANDI_TABLE", entry_ANDI_imm_major);
+    emit_shift_table("ALU_SAL_TABLE", entry_SAL);
+    emit_shift_table("ALU_SAR_TABLE", entry_SAR);
+    return 0;
+}
@@ -0,0 +1,171 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include "../includes/registers.h"
+#include "../includes/memory.h"
+#include "../includes/sim_protocol.h"
+
+/**
+ * Minimal client for sim_server.
+ * Sends the same program as N pipelined jobs on one connection, keeping the
+ * server's window (see sim_protocol.h) in flight, collects the results and prints
+ * the first one plus the observed throughput.
+ *
+ * Usage: sim_client program.txt [--socket path] [--jobs N] [--cycles N] [--memory]
+ */
+
+static int readAll(int fd, void* buffer, size_t length) {
+    char* p = buffer;
+    while (length > 0) {
+        ssize_t n = read(fd, p, length);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return -1;
+        p += n;
+        length -= (size_t)n;
+    }
+    return 0;
+}
+
+static int writeAll(int fd, const void* buffer, size_t length) {
+    const char* p = buffer;
+    while (length > 0) {
+        ssize_t n = write(fd, p, length);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return -1;
+        p += n;
+        length -= (size_t)n;
+    }
+    return 0;
+}
+
+static int sendJob(int fd, uint32_t id, uint8_t outputs, uint32_t cycleLimit,
+                   const char* program, uint32_t length) {
+    SimJobHeader header;
+    memset(&header, 0, sizeof(header));
+    header.magic = SIM_PROTOCOL_JOB_MAGIC;
+    header.jobId = id;
+    header.payloadType = SIM_PAYLOAD_SOURCE;
+    header.outputs = outputs;
+    header.cycleLimit = cycleLimit;
+    header.payloadLength = length;
+    if (writeAll(fd, &header, sizeof(header)) != 0 || writeAll(fd, program, length) != 0) {
+        perror("Error: write");
+        return -1;
+    }
+    return 0;
+}
+
+static char* readFile(const char* filename, uint32_t* length) {
+    FILE* file = fopen(filename, "rb");
+    if (!file) return NULL;
+    char* buffer = malloc(SIM_PROTOCOL_MAX_PAYLOAD);
+    *length = buffer ? (uint32_t)fread(buffer, 1, SIM_PROTOCOL_MAX_PAYLOAD, file) : 0;
+    fclose(file);
+    return buffer;
+}
+
+int main(int argc, char* argv[]) {
+    const char* socketPath = SIM_DEFAULT_SOCKET_PATH;
+    const char* programFile = NULL;
+    uint32_t jobs = 1;
+    uint32_t cycleLimit = 0;
+    uint8_t outputs = SIM_OUTPUT_REGISTERS;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--socket") == 0 && i + 1 < argc) {
+            socketPath = argv[++i];
+        } else if (strcmp(argv[i], "--jobs") == 0 && i + 1 < argc) {
+            jobs = (uint32_t)strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--cycles") == 0 && i + 1 < argc) {
+            cycleLimit = (uint32_t)strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--memory") == 0) {
+            outputs |= SIM_OUTPUT_DATA_MEMORY;
+        } else if (argv[i][0] != '-' && !programFile) {
+            programFile = argv[i];
+        } else {
+            programFile = NULL;
+            break;
+        }
+    }
+    if (!programFile || jobs == 0) {
+        printf("Usage: %s program.txt [--socket path] [--jobs N] [--cycles N] [--memory]\n", argv[0]);
+        return 1;
+    }
+
+    uint32_t length;
+    char* program = readFile(programFile, &length);
+    if (!program) {
+        printf("Error: Could not open file %s\n", programFile);
+        return 1;
+    }
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, socketPath, sizeof(addr.sun_path) - 1);
+    if (fd < 0 || connect(fd, (struct sockaddr*)&addr, sizeof(addr)) != 0) {
+        perror("Error: connect");
+        return 1;
+    }
+
+    struct timespec start, end;
+    timespec_get(&start, TIME_UTC);
+
+    // Fill the server's window, then send one more job per result read
+    uint32_t window = SIM_PROTOCOL_MAX_OUTSTANDING_BYTES / SIM_RESULT_BYTES(outputs);
+    if (window > SIM_PROTOCOL_MAX_OUTSTANDING) window = SIM_PROTOCOL_MAX_OUTSTANDING;
+    if (window == 0) window = 1;
+    uint32_t sent = 0;
+    while (sent < jobs && sent < window) {
+        if (sendJob(fd, sent++, outputs, cycleLimit, program, length) != 0) return 1;
+    }
+
+    uint64_t totalCycles = 0;
+    int8_t regs[REGISTER_COUNT];
+    int8_t memory[DATA_MEMORY_SIZE];
+    for (uint32_t received = 0; received < jobs; received++) {
+        SimJobResult result;
+        if (readAll(fd, &result, sizeof(result)) != 0 || result.magic != SIM_PROTOCOL_RESULT_MAGIC) {
+            printf("Error: Connection closed after %u results\n", received);
+            return 1;
+        }
+        if (result.outputs & SIM_OUTPUT_REGISTERS) readAll(fd, regs, sizeof(regs));
+        if (result.outputs & SIM_OUTPUT_DATA_MEMORY) readAll(fd, memory, sizeof(memory));
+        totalCycles += result.cycles;
+        if (sent < jobs && sendJob(fd, sent++, outputs, cycleLimit, program, length) != 0) return 1;
+
+        if (received == 0) {
+            printf("Job %u: status %u, %u instructions loaded, %llu cycles, %llu executed, "
+                   "%u branches taken, %u memory writes\n",
+                   result.jobId, result.status, result.instructionsLoaded,
+                   (unsigned long long)result.cycles, (unsigned long long)result.instructions,
+                   result.branchesTaken, result.memoryWrites);
+            printf("PC: %d (0x%04X) SREG: 0x%02X\n", result.pc, result.pc, result.sreg);
+            if (result.outputs & SIM_OUTPUT_REGISTERS) {
+                for (int r = 0; r < REGISTER_COUNT; r++) {
+                    if (regs[r] != 0) printf("R%d: %d (0x%02X)\n", r, regs[r], (uint8_t)regs[r]);
+                }
+            }
+            if (result.outputs & SIM_OUTPUT_DATA_MEMORY) {
+                for (int a = 0; a < DATA_MEMORY_SIZE; a++) {
+                    if (memory[a] != 0) printf("Addr [%d] : %d (0x%02X)\n", a, memory[a], (uint8_t)memory[a]);
+                }
+            }
+        }
+    }
+
+    timespec_get(&end, TIME_UTC);
+    double seconds = (double)(end.tv_sec - start.tv_sec) + (double)(end.tv_nsec - start.tv_nsec) / 1e9;
+    printf("%u jobs in %.3f s (%.0f jobs/s, %llu simulated cycles)\n",
+           jobs, seconds, jobs / seconds, (unsigned long long)totalCycles);
+
+    close(fd);
+    free(program);
+    return 0;
+}
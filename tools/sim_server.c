@@ -0,0 +1,520 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include "../includes/simulator.h"
+#include "../includes/sim_protocol.h"
+#include "../includes/profile.h"
+
+/**
+ * Persistent simulation server.
+ * Keeps one pre-initialized Simulator per worker thread and serves jobs
+ * received over a Unix domain socket (see includes/sim_protocol.h). Workers
+ * pick jobs from a shared queue and hand each result to the connection's
+ * writer thread, so a client that stops reading its socket stalls only its
+ * own connection. Each connection's reader queues jobs until the connection
+ * has a window's worth of unsent results (SIM_PROTOCOL_MAX_OUTSTANDING jobs
+ * or SIM_PROTOCOL_MAX_OUTSTANDING_BYTES) and then stops reading, so a client
+ * sending faster than it reads is slowed down by its socket.
+ *
+ * With --cache DIR, jobs whose program, initial state and cycle limit match
+ * an earlier job (of this or any other server sharing DIR) are answered from
+ * the on-disk result store without simulating.
+ *
+ * SIGINT or SIGTERM stops accepting connections, removes the socket and
+ * exits, which prints the host profile in PROFILE=1 builds.
+ *
+ * Usage: sim_server [socket_path] [--workers N] [--max-cycles N] [--engine pipeline|blocks]
+ *                   [--cache DIR [--cache-size MB]]
+ */
+
+#define DEFAULT_MAX_CYCLES 10000000u
+#define DEFAULT_CACHE_MB   64
+
+// ================== Connections and Jobs ==================
+
+// A finished result frame waiting for the connection's writer thread
+typedef struct Reply {
+    struct Reply* next;
+    uint32_t reserved;           // Window bytes the job was admitted with
+    uint32_t length;
+    char data[];                 // SimJobResult + selected sections
+} Reply;
+
+typedef struct {
+    int fd;
+    pthread_mutex_t lock;        // Guards the fields below
+    pthread_cond_t changed;      // New reply, reply sent, or reader gone
+    Reply* outHead;              // Results not yet written, in completion order
+    Reply* outTail;
+    uint32_t outstandingJobs;    // Admitted jobs whose result is not yet written
+    uint32_t outstandingBytes;   // Result bytes reserved by those jobs
+    bool readerDone;
+    bool broken;                 // A write failed; later results are dropped
+} Connection;
+
+typedef struct Job {
+    Connection* conn;
+    SimJobHeader header;
+    char* payload;
+    uint32_t reserved;           // SIM_RESULT_BYTES of the requested outputs
+    struct Job* next;
+} Job;
+
+// Per-worker event counters, fed by the simulator callbacks
+typedef struct {
+    uint32_t branchesTaken;
+    uint32_t memoryWrites;
+} WorkerCounters;
+
+static Job* queueHead = NULL;
+static Job* queueTail = NULL;
+static pthread_mutex_t queueLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t queueReady = PTHREAD_COND_INITIALIZER;
+static uint32_t maxCycles = DEFAULT_MAX_CYCLES;
+static SimEngine engine = SIM_ENGINE_PIPELINE;
+static ResultCache* cache = NULL;      // Shared by all workers; NULL without --cache
+static volatile sig_atomic_t stopping = 0;
+
+static int readAll(int fd, void* buffer, size_t length) {
+    char* p = buffer;
+    while (length > 0) {
+        ssize_t n = read(fd, p, length);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return -1;
+        p += n;
+        length -= (size_t)n;
+    }
+    return 0;
+}
+
+static int writeAll(int fd, const void* buffer, size_t length) {
+    const char* p = buffer;
+    while (length > 0) {
+        ssize_t n = write(fd, p, length);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return -1;
+        p += n;
+        length -= (size_t)n;
+    }
+    return 0;
+}
+
+/**
+ * Hands a finished result to the connection's writer; never blocks on the
+ * socket. A NULL reply (out of memory) gives the job's window back and
+ * drops the connection, as its client would otherwise wait forever.
+ */
+static void postReply(Connection* conn, Reply* reply, uint32_t reserved) {
+    pthread_mutex_lock(&conn->lock);
+    if (reply) {
+        if (conn->outTail) {
+            conn->outTail->next = reply;
+        } else {
+            conn->outHead = reply;
+        }
+        conn->outTail = reply;
+    } else {
+        conn->outstandingJobs--;
+        conn->outstandingBytes -= reserved;
+        conn->broken = true;
+        shutdown(conn->fd, SHUT_RDWR);
+    }
+    pthread_cond_broadcast(&conn->changed);
+    pthread_mutex_unlock(&conn->lock);
+}
+
+static void enqueueJob(Job* job) {
+    pthread_mutex_lock(&queueLock);
+    if (queueTail) {
+        queueTail->next = job;
+    } else {
+        queueHead = job;
+    }
+    queueTail = job;
+    pthread_cond_signal(&queueReady);
+    pthread_mutex_unlock(&queueLock);
+}
+
+static Job* dequeueJob() {
+    pthread_mutex_lock(&queueLock);
+    while (!queueHead) {
+        pthread_cond_wait(&queueReady, &queueLock);
+    }
+    Job* job = queueHead;
+    queueHead = job->next;
+    if (!queueHead) {
+        queueTail = NULL;
+    }
+    pthread_mutex_unlock(&queueLock);
+    return job;
+}
+
+// ================== Workers ==================
+
+static void countBranch(void* user, uint16_t targetPC) {
+    (void)targetPC;
+    ((WorkerCounters*)user)->branchesTaken++;
+}
+
+static void countMemoryWrite(void* user, uint16_t address, int8_t value) {
+    (void)address;
+    (void)value;
+    ((WorkerCounters*)user)->memoryWrites++;
+}
+
+// Runs one job on the worker's simulator and fills in the result
+static void runJob(Simulator* sim, WorkerCounters* counters, const Job* job, SimJobResult* result,
+                   CachedResult* outcome, int8_t* regs, int8_t* memory) {
+    const SimJobHeader* header = &job->header;
+    int loaded;
+
+    if (header->payloadType == SIM_PAYLOAD_SOURCE) {
+        loaded = simLoadSource(sim, job->payload, header->payloadLength);
+    } else {
+        loaded = simLoadImage(sim, (const uint16_t*)job->payload, header->payloadLength / sizeof(uint16_t));
+    }
+
+    uint32_t limit = header->cycleLimit;
+    if (limit == 0 || limit > maxCycles) {
+        limit = maxCycles;
+    }
+    RunKey key;
+    bool keyed = cache && simRunKey(sim, limit, &key);
+    if (keyed && lookupResult(cache, &key, outcome)) {
+        simApplyResult(sim, outcome);
+    } else {
+        counters->branchesTaken = 0;
+        counters->memoryWrites = 0;
+        simCaptureResult(sim, simRun(sim, limit), outcome);
+        outcome->counters[0] = counters->branchesTaken;
+        outcome->counters[1] = counters->memoryWrites;
+        if (keyed) storeResult(cache, &key, outcome);
+    }
+
+    result->status = outcome->reason == SIM_HALTED ? SIM_JOB_HALTED : SIM_JOB_CYCLE_LIMIT;
+    result->instructionsLoaded = (uint16_t)loaded;
+    result->sreg = outcome->sreg;
+    result->pc = outcome->pc;
+    result->cycles = outcome->cycles;
+    result->instructions = outcome->instructions;
+    result->branchesTaken = (uint32_t)outcome->counters[0];
+    result->memoryWrites = (uint32_t)outcome->counters[1];
+
+    if (header->outputs & SIM_OUTPUT_REGISTERS) {
+        simReadRegisters(sim, regs);
+        result->outputs |= SIM_OUTPUT_REGISTERS;
+        result->payloadLength += REGISTER_COUNT;
+    }
+    if (header->outputs & SIM_OUTPUT_DATA_MEMORY) {
+        simReadDataMemory(sim, 0, memory, DATA_MEMORY_SIZE);
+        result->outputs |= SIM_OUTPUT_DATA_MEMORY;
+        result->payloadLength += DATA_MEMORY_SIZE;
+    }
+}
+
+static void* workerMain(void* arg) {
+    (void)arg;
+    WorkerCounters counters = {0};
+    SimCallbacks callbacks = {0};
+    callbacks.onBranch = countBranch;
+    callbacks.onMemoryWrite = countMemoryWrite;
+    callbacks.user = &counters;
+
+    // The pooled instance lives in this thread for the server's lifetime
+    Simulator* sim = simCreate(&callbacks);
+    if (!sim) {
+        fprintf(stderr, "Error: Could not create simulator\n");
+        exit(1);
+    }
+    simSetEngine(sim, engine);
+
+    int8_t regs[REGISTER_COUNT];
+    int8_t memory[DATA_MEMORY_SIZE];
+    CachedResult outcome;
+
+    while (true) {
+        Job* job = dequeueJob();
+        SimJobResult result;
+        memset(&result, 0, sizeof(result));
+        result.magic = SIM_PROTOCOL_RESULT_MAGIC;
+        result.jobId = job->header.jobId;
+
+        if (job->header.payloadType > SIM_PAYLOAD_IMAGE || !job->payload) {
+            result.status = SIM_JOB_BAD_REQUEST;
+        } else {
+            runJob(sim, &counters, job, &result, &outcome, regs, memory);
+        }
+
+        uint32_t length = (uint32_t)sizeof(result) + result.payloadLength;
+        Reply* reply = malloc(sizeof(Reply) + length);
+        if (reply) {
+            reply->next = NULL;
+            reply->reserved = job->reserved;
+            reply->length = length;
+            char* p = reply->data;
+            memcpy(p, &result, sizeof(result));
+            p += sizeof(result);
+            if (result.outputs & SIM_OUTPUT_REGISTERS) {
+                memcpy(p, regs, sizeof(regs));
+                p += sizeof(regs);
+            }
+            if (result.outputs & SIM_OUTPUT_DATA_MEMORY) {
+                memcpy(p, memory, sizeof(memory));
+            }
+        }
+        postReply(job->conn, reply, job->reserved);
+        // Workers never exit, so their samples are merged as they go
+        PROFILE_FLUSH();
+
+        free(job->payload);
+        free(job);
+    }
+    return NULL;
+}
+
+// ================== Connection Readers and Writers ==================
+
+// True while the connection's window has no room for a job whose result
+// takes reserved bytes; a lone job is always admitted, however large
+static bool windowFull(const Connection* conn, uint32_t reserved) {
+    return conn->outstandingJobs > 0 &&
+           (conn->outstandingJobs >= SIM_PROTOCOL_MAX_OUTSTANDING ||
+            conn->outstandingBytes + reserved > SIM_PROTOCOL_MAX_OUTSTANDING_BYTES);
+}
+
+static void* readerMain(void* arg) {
+    Connection* conn = arg;
+
+    while (true) {
+        Job* job = calloc(1, sizeof(Job));
+        if (!job) break;
+        if (readAll(conn->fd, &job->header, sizeof(job->header)) != 0 ||
+            job->header.magic != SIM_PROTOCOL_JOB_MAGIC) {
+            free(job);
+            break;
+        }
+
+        // With the window full, leave the payload and the requests behind it
+        // in the socket until the writer has sent enough results
+        job->reserved = SIM_RESULT_BYTES(job->header.outputs);
+        pthread_mutex_lock(&conn->lock);
+        while (!conn->broken && windowFull(conn, job->reserved)) {
+            pthread_cond_wait(&conn->changed, &conn->lock);
+        }
+        bool broken = conn->broken;
+        pthread_mutex_unlock(&conn->lock);
+        if (broken) {
+            free(job);
+            break;
+        }
+
+        uint32_t length = job->header.payloadLength;
+        if (length > SIM_PROTOCOL_MAX_PAYLOAD) {
+            // Drain the oversized payload; the worker reports SIM_JOB_BAD_REQUEST
+            char discard[4096];
+            while (length > 0) {
+                size_t chunk = length < sizeof(discard) ? length : sizeof(discard);
+                if (readAll(conn->fd, discard, chunk) != 0) break;
+                length -= (uint32_t)chunk;
+            }
+            if (length > 0) {
+                free(job);
+                break;
+            }
+        } else {
+            job->payload = malloc(length ? length : 1);
+            if (!job->payload || readAll(conn->fd, job->payload, length) != 0) {
+                free(job->payload);
+                free(job);
+                break;
+            }
+        }
+
+        job->conn = conn;
+        pthread_mutex_lock(&conn->lock);
+        conn->outstandingJobs++;
+        conn->outstandingBytes += job->reserved;
+        pthread_mutex_unlock(&conn->lock);
+        enqueueJob(job);
+    }
+
+    shutdown(conn->fd, SHUT_RD);
+    pthread_mutex_lock(&conn->lock);
+    conn->readerDone = true;
+    pthread_cond_broadcast(&conn->changed);
+    pthread_mutex_unlock(&conn->lock);
+    return NULL;
+}
+
+// Writes results in completion order; owns the connection and frees it once
+// the reader has stopped and every admitted job's result has been handled
+static void* writerMain(void* arg) {
+    Connection* conn = arg;
+
+    pthread_mutex_lock(&conn->lock);
+    while (true) {
+        while (!conn->outHead && !(conn->readerDone && conn->outstandingJobs == 0)) {
+            pthread_cond_wait(&conn->changed, &conn->lock);
+        }
+        Reply* reply = conn->outHead;
+        if (!reply) break;
+        conn->outHead = reply->next;
+        if (!conn->outHead) {
+            conn->outTail = NULL;
+        }
+        bool broken = conn->broken;
+        pthread_mutex_unlock(&conn->lock);
+
+        if (!broken && writeAll(conn->fd, reply->data, reply->length) != 0) {
+            // Wake the reader too; nobody is left to read the results
+            shutdown(conn->fd, SHUT_RDWR);
+            broken = true;
+        }
+
+        pthread_mutex_lock(&conn->lock);
+        conn->broken |= broken;
+        conn->outstandingJobs--;
+        conn->outstandingBytes -= reply->reserved;
+        pthread_cond_broadcast(&conn->changed);
+        free(reply);
+    }
+    pthread_mutex_unlock(&conn->lock);
+
+    close(conn->fd);
+    pthread_cond_destroy(&conn->changed);
+    pthread_mutex_destroy(&conn->lock);
+    free(conn);
+    return NULL;
+}
+
+// ================== Main ==================
+
+static void requestStop(int signal) {
+    (void)signal;
+    stopping = 1;
+}
+
+// Starts a detached thread that leaves SIGINT/SIGTERM to the accept loop
+static int startThread(void* (*entry)(void*), void* arg) {
+    sigset_t stopSignals, previous;
+    sigemptyset(&stopSignals);
+    sigaddset(&stopSignals, SIGINT);
+    sigaddset(&stopSignals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &stopSignals, &previous);
+    pthread_t thread;
+    int status = pthread_create(&thread, NULL, entry, arg);
+    pthread_sigmask(SIG_SETMASK, &previous, NULL);
+    if (status == 0) {
+        pthread_detach(thread);
+    }
+    return status;
+}
+
+int main(int argc, char* argv[]) {
+    const char* socketPath = SIM_DEFAULT_SOCKET_PATH;
+    long workers = sysconf(_SC_NPROCESSORS_ONLN);
+    const char* cacheDir = NULL;
+    uint64_t cacheMegabytes = DEFAULT_CACHE_MB;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--workers") == 0 && i + 1 < argc) {
+            workers = strtol(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--max-cycles") == 0 && i + 1 < argc) {
+            maxCycles = (uint32_t)strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--engine") == 0 && i + 1 < argc) {
+            engine = strcmp(argv[++i], "blocks") == 0 ? SIM_ENGINE_BLOCKS : SIM_ENGINE_PIPELINE;
+        } else if (strcmp(argv[i], "--cache") == 0 && i + 1 < argc) {
+            cacheDir = argv[++i];
+        } else if (strcmp(argv[i], "--cache-size") == 0 && i + 1 < argc) {
+            cacheMegabytes = strtoull(argv[++i], NULL, 10);
+        } else if (argv[i][0] == '-') {
+            printf("Usage: %s [socket_path] [--workers N] [--max-cycles N] [--engine pipeline|blocks]\n"
+                   "       [--cache DIR [--cache-size MB]]\n", argv[0]);
+            return 1;
+        } else {
+            socketPath = argv[i];
+        }
+    }
+    if (workers < 1) workers = 1;
+    if (cacheDir) {
+        cache = openResultCache(cacheDir, cacheMegabytes << 20);
+        if (!cache) {
+            fprintf(stderr, "Error: Could not open result cache %s\n", cacheDir);
+            return 1;
+        }
+    }
+
+    signal(SIGPIPE, SIG_IGN);
+    // No SA_RESTART, so a stop request interrupts accept()
+    struct sigaction stop;
+    memset(&stop, 0, sizeof(stop));
+    stop.sa_handler = requestStop;
+    sigaction(SIGINT, &stop, NULL);
+    sigaction(SIGTERM, &stop, NULL);
+
+    int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listener < 0) {
+        perror("Error: socket");
+        return 1;
+    }
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, socketPath, sizeof(addr.sun_path) - 1);
+    unlink(socketPath);
+    if (bind(listener, (struct sockaddr*)&addr, sizeof(addr)) != 0 || listen(listener, 64) != 0) {
+        perror("Error: bind/listen");
+        return 1;
+    }
+
+    for (long i = 0; i < workers; i++) {
+        if (startThread(workerMain, NULL) != 0) {
+            fprintf(stderr, "Error: Could not start worker %ld\n", i);
+            return 1;
+        }
+    }
+    printf("[SERVER] Listening on %s with %ld workers\n", socketPath, workers);
+    fflush(stdout);
+
+    while (!stopping) {
+        int fd = accept(listener, NULL, NULL);
+        if (fd < 0) {
+            if (errno == EINTR) continue;
+            perror("Error: accept");
+            break;
+        }
+        Connection* conn = calloc(1, sizeof(Connection));
+        if (!conn) {
+            close(fd);
+            continue;
+        }
+        conn->fd = fd;
+        pthread_mutex_init(&conn->lock, NULL);
+        pthread_cond_init(&conn->changed, NULL);
+
+        if (startThread(writerMain, conn) != 0) {
+            close(fd);
+            pthread_cond_destroy(&conn->changed);
+            pthread_mutex_destroy(&conn->lock);
+            free(conn);
+            continue;
+        }
+        if (startThread(readerMain, conn) != 0) {
+            // The writer sees no reader and no jobs, and closes the connection
+            pthread_mutex_lock(&conn->lock);
+            conn->readerDone = true;
+            pthread_cond_broadcast(&conn->changed);
+            pthread_mutex_unlock(&conn->lock);
+        }
+    }
+
+    close(listener);
+    unlink(socketPath);
+    return 0;
+}
@@ -0,0 +1,246 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "../includes/retire_trace.h"
+#include "../includes/isa.h"
+
+/**
+ * Trace-driven timing replay.
+ * Maps a retirement trace recorded with `processor --record-trace` and
+ * replays it through an in-order timing model once per configuration, each
+ * configuration on its own thread over the same read-only mapping. No
+ * functional simulation happens here, so a knob sweep costs one pass over
+ * the trace per configuration.
+ *
+ * The model issues one instruction per cycle into EX. An instruction waits
+ * for its source registers (result latencies per unit), a data access holds
+ * the pipeline for `mem` extra cycles and a taken branch inserts `branch`
+ * bubbles. With the defaults it reproduces the recorded IF/ID/EX cycle count.
+ *
+ * Usage: trace_replay trace.bin [config ...]
+ *   config: comma-separated key=value list, e.g. name=fast-id,branch=1,load=2
+ *   keys:   name, depth (3), branch (2), alu (1), mul (1), load (1), mem (0)
+ */
+
+#define MAX_CONFIGS 32
+
+typedef struct {
+    char name[32];
+    uint32_t depth;            // Cycle in which the first instruction executes
+    uint32_t branchPenalty;    // Bubbles after a taken branch
+    uint32_t aluLatency;       // Cycles until an ALU result can be consumed
+    uint32_t mulLatency;       // Cycles until a MUL result can be consumed
+    uint32_t loadLatency;      // Cycles until an LDR result can be consumed
+    uint32_t memLatency;       // Extra cycles a data access holds the pipeline
+} TimingConfig;
+
+typedef struct {
+    uint64_t cycles;
+    uint64_t dataStalls;
+    uint64_t memoryStalls;
+    uint64_t branchBubbles;
+    double seconds;
+} TimingResult;
+
+typedef struct {
+    const RetireRecord* records;
+    uint64_t count;
+    const TimingConfig* config;
+    TimingResult* result;
+} ReplayJob;
+
+static const char* DEFAULT_CONFIGS[] = {
+    "name=base",
+    "name=branch-in-id,branch=1",
+    "name=load-use,load=2",
+    "name=slow-mem,mem=2",
+    "name=mul-3,mul=3",
+};
+
+// ================== Configurations ==================
+
+/**
+ * Parses "key=value,key=value" over the default (recorded) timing.
+ * @return: 0 on success, -1 on an unknown key.
+ */
+static int parseConfig(const char* text, TimingConfig* config, int index) {
+    TimingConfig defaults = {"", 3, 2, 1, 1, 1, 0};
+    *config = defaults;
+    snprintf(config->name, sizeof(config->name), "config-%d", index);
+
+    char buffer[256];
+    snprintf(buffer, sizeof(buffer), "%s", text);
+    for (char* item = strtok(buffer, ","); item; item = strtok(NULL, ",")) {
+        char* value = strchr(item, '=');
+        if (!value) return -1;
+        *value++ = '\0';
+        uint32_t number = (uint32_t)strtoul(value, NULL, 10);
+
+        if (strcmp(item, "name") == 0) {
+            snprintf(config->name, sizeof(config->name), "%s", value);
+        } else if (strcmp(item, "depth") == 0) {
+            config->depth = number;
+        } else if (strcmp(item, "branch") == 0) {
+            config->branchPenalty = number;
+        } else if (strcmp(item, "alu") == 0) {
+            config->aluLatency = number;
+        } else if (strcmp(item, "mul") == 0) {
+            config->mulLatency = number;
+        } else if (strcmp(item, "load") == 0) {
+            config->loadLatency = number;
+        } else if (strcmp(item, "mem") == 0) {
+            config->memLatency = number;
+        } else {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+// ================== Timing Model ==================
+
+static double nowSeconds() {
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static void replay(const RetireRecord* records, uint64_t count, const TimingConfig* config,
+                   TimingResult* result) {
+    // Cycle from which each register's value can be consumed in EX;
+    // indexed by the raw field so RETIRE_NO_REG needs no branch
+    uint64_t ready[256] = {0};
+    uint64_t earliest = config->depth;
+    uint64_t issue = 0;
+    bool lastTaken = false;
+
+    memset(result, 0, sizeof(*result));
+    for (uint64_t i = 0; i < count; i++) {
+        const RetireRecord* r = &records[i];
+
+        issue = earliest;
+        uint64_t operands = ready[r->src1] > ready[r->src2] ? ready[r->src1] : ready[r->src2];
+        if (operands > issue) {
+            result->dataStalls += operands - issue;
+            issue = operands;
+        }
+
+        if (r->dest != RETIRE_NO_REG) {
+            uint32_t latency = r->opcode == OP_LDR ? config->loadLatency :
+                               r->opcode == OP_MUL ? config->mulLatency : config->aluLatency;
+            ready[r->dest] = issue + latency;
+        }
+
+        earliest = issue + 1;
+        if (r->flags & (RETIRE_MEM_READ | RETIRE_MEM_WRITE)) {
+            earliest += config->memLatency;
+            result->memoryStalls += config->memLatency;
+        }
+        lastTaken = (r->flags & RETIRE_TAKEN) != 0;
+        if (lastTaken) {
+            earliest += config->branchPenalty;
+            result->branchBubbles += config->branchPenalty;
+        }
+    }
+
+    // The HALT fetch after a final taken branch ends the run before the bubbles do
+    if (count == 0) {
+        result->cycles = 1;
+    } else {
+        result->cycles = issue + (lastTaken && config->branchPenalty > 0 ? config->branchPenalty - 1 : 0);
+    }
+}
+
+static void* replayMain(void* arg) {
+    ReplayJob* job = arg;
+    double start = nowSeconds();
+    replay(job->records, job->count, job->config, job->result);
+    job->result->seconds = nowSeconds() - start;
+    return NULL;
+}
+
+// ================== Main ==================
+
+int main(int argc, char* argv[]) {
+    if (argc < 2 || argv[1][0] == '-') {
+        printf("Usage: %s trace.bin [config ...]\n", argv[0]);
+        printf("  config: name=N,depth=3,branch=2,alu=1,mul=1,load=1,mem=0 (any subset)\n");
+        return 1;
+    }
+
+    int fd = open(argv[1], O_RDONLY);
+    struct stat info;
+    if (fd < 0 || fstat(fd, &info) != 0 || (size_t)info.st_size < sizeof(RetireTraceHeader)) {
+        printf("Error: Could not open trace %s\n", argv[1]);
+        return 1;
+    }
+    const char* mapped = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapped == MAP_FAILED) {
+        perror("Error: mmap");
+        return 1;
+    }
+
+    const RetireTraceHeader* header = (const RetireTraceHeader*)mapped;
+    if (header->magic != RETIRE_TRACE_MAGIC || header->version != RETIRE_TRACE_VERSION ||
+        header->recordSize != sizeof(RetireRecord) ||
+        header->recordCount > ((size_t)info.st_size - sizeof(*header)) / sizeof(RetireRecord)) {
+        printf("Error: %s is not a complete retirement trace\n", argv[1]);
+        return 1;
+    }
+    const RetireRecord* records = (const RetireRecord*)(mapped + sizeof(*header));
+
+    const char** texts = argc > 2 ? (const char**)&argv[2] : DEFAULT_CONFIGS;
+    int configCount = argc > 2 ? argc - 2 : (int)(sizeof(DEFAULT_CONFIGS) / sizeof(DEFAULT_CONFIGS[0]));
+    if (configCount > MAX_CONFIGS) configCount = MAX_CONFIGS;
+
+    static TimingConfig configs[MAX_CONFIGS];
+    static TimingResult results[MAX_CONFIGS];
+    ReplayJob jobs[MAX_CONFIGS];
+    pthread_t threads[MAX_CONFIGS];
+    bool threaded[MAX_CONFIGS];
+
+    for (int c = 0; c < configCount; c++) {
+        if (parseConfig(texts[c], &configs[c], c) != 0) {
+            printf("Error: Bad configuration \"%s\"\n", texts[c]);
+            return 1;
+        }
+    }
+
+    double start = nowSeconds();
+    for (int c = 0; c < configCount; c++) {
+        jobs[c] = (ReplayJob){records, header->recordCount, &configs[c], &results[c]};
+        threaded[c] = pthread_create(&threads[c], NULL, replayMain, &jobs[c]) == 0;
+        if (!threaded[c]) {
+            replayMain(&jobs[c]);
+        }
+    }
+    for (int c = 0; c < configCount; c++) {
+        if (threaded[c]) pthread_join(threads[c], NULL);
+    }
+    double wall = nowSeconds() - start;
+
+    printf("Trace %s: %llu instructions, %llu recorded cycles\n", argv[1],
+           (unsigned long long)header->recordCount, (unsigned long long)header->recordedCycles);
+    printf("%-16s %12s %7s %12s %12s %12s %10s\n",
+           "config", "cycles", "CPI", "data stall", "mem stall", "branch", "Mrec/s");
+    for (int c = 0; c < configCount; c++) {
+        const TimingResult* r = &results[c];
+        printf("%-16s %12llu %7.3f %12llu %12llu %12llu %10.1f\n", configs[c].name,
+               (unsigned long long)r->cycles,
+               header->recordCount ? (double)r->cycles / header->recordCount : 0.0,
+               (unsigned long long)r->dataStalls, (unsigned long long)r->memoryStalls,
+               (unsigned long long)r->branchBubbles,
+               r->seconds > 0 ? header->recordCount / r->seconds / 1e6 : 0.0);
+    }
+    printf("%d configurations in %.3f s\n", configCount, wall);
+
+    munmap((void*)mapped, (size_t)info.st_size);
+    return 0;
+}